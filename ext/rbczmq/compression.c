@@ -0,0 +1,227 @@
+#include "rbczmq_ext.h"
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+/* Payload compression for sockets with compression enabled. Payloads of at least min_size bytes are deflated, all
+   others - and those that don't shrink - are sent as is behind a raw header. Both peers have to enable compression,
+   and receivers reject payloads without a known header. */
+
+static void rb_czmq_compression_free(void *data, ZMQ_UNUSED void *hint)
+{
+    free(data);
+}
+
+/*
+ * :nodoc:
+ *  Writes the magic and flag byte of a header.
+ *
+*/
+static void rb_czmq_compression_header(unsigned char *buffer, unsigned char flag)
+{
+    memcpy(buffer, ZMQ_COMPRESSION_MAGIC, ZMQ_COMPRESSION_MAGIC_SIZE);
+    buffer[ZMQ_COMPRESSION_MAGIC_SIZE] = flag;
+}
+
+/*
+ * :nodoc:
+ *  Returns the flag byte of a payload, or -1 if it doesn't start with a header.
+ *
+*/
+static int rb_czmq_compression_flag(const unsigned char *data, size_t size)
+{
+    if (size < ZMQ_COMPRESSION_RAW_HEADER_SIZE || memcmp(data, ZMQ_COMPRESSION_MAGIC, ZMQ_COMPRESSION_MAGIC_SIZE) != 0)
+        return -1;
+    return data[ZMQ_COMPRESSION_MAGIC_SIZE];
+}
+
+/*
+ * :nodoc:
+ *  Deflates data into a malloc'ed buffer that includes the header, or returns NULL if the payload is too small, too
+ *  large, doesn't shrink or the codec isn't available.
+ *
+*/
+static unsigned char *rb_czmq_deflate(zmq_compression *compression, const void *data, size_t size, size_t *length)
+{
+#ifdef HAVE_LIBZ
+    uLongf bound;
+    unsigned char *buffer = NULL;
+    if (!ZmqCompressible(compression, size) || size > 0xFFFFFFFFUL) return NULL;
+    bound = compressBound((uLong)size);
+    buffer = malloc(ZMQ_COMPRESSION_HEADER_SIZE + bound);
+    if (buffer == NULL) return NULL;
+    if (compress2(buffer + ZMQ_COMPRESSION_HEADER_SIZE, &bound, data, (uLong)size, compression->level) != Z_OK ||
+        ZMQ_COMPRESSION_HEADER_SIZE + bound > size) {
+        free(buffer);
+        return NULL;
+    }
+    rb_czmq_compression_header(buffer, ZMQ_COMPRESSION_FLAG_ZLIB);
+    rb_czmq_store(buffer + ZMQ_COMPRESSION_RAW_HEADER_SIZE, (uint64_t)size, 4, true);
+    *length = ZMQ_COMPRESSION_HEADER_SIZE + bound;
+    return buffer;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * :nodoc:
+ *  Validates the header of a payload and returns its uncompressed size, or ZMQ_COMPRESSION_EFORMAT.
+ *
+*/
+static long rb_czmq_inflated_size(const unsigned char *data, size_t size)
+{
+    int flag = rb_czmq_compression_flag(data, size);
+#ifdef HAVE_LIBZ
+    uint64_t length;
+#endif
+    if (flag == ZMQ_COMPRESSION_FLAG_RAW) return (long)(size - ZMQ_COMPRESSION_RAW_HEADER_SIZE);
+#ifdef HAVE_LIBZ
+    if (size >= ZMQ_COMPRESSION_HEADER_SIZE && flag == ZMQ_COMPRESSION_FLAG_ZLIB) {
+        length = rb_czmq_load(data + ZMQ_COMPRESSION_RAW_HEADER_SIZE, 4, true);
+        if (length / ZMQ_COMPRESSION_MAX_RATIO <= size) return (long)length;
+    }
+#endif
+    errno = EPROTO;
+    return ZMQ_COMPRESSION_EFORMAT;
+}
+
+/*
+ * :nodoc:
+ *  Restores a payload validated by rb_czmq_inflated_size into a buffer of exactly the uncompressed size.
+ *
+*/
+static int rb_czmq_inflate(const unsigned char *data, size_t size, unsigned char *buffer, size_t length)
+{
+#ifdef HAVE_LIBZ
+    uLongf inflated = (uLongf)length;
+#endif
+    if (data[ZMQ_COMPRESSION_MAGIC_SIZE] == ZMQ_COMPRESSION_FLAG_RAW) {
+        memcpy(buffer, data + ZMQ_COMPRESSION_RAW_HEADER_SIZE, length);
+        return 0;
+    }
+#ifdef HAVE_LIBZ
+    if (uncompress(buffer, &inflated, data + ZMQ_COMPRESSION_HEADER_SIZE, (uLong)(size - ZMQ_COMPRESSION_HEADER_SIZE)) == Z_OK &&
+        inflated == (uLongf)length) return 0;
+#endif
+    errno = EPROTO;
+    return ZMQ_COMPRESSION_EFORMAT;
+}
+
+/*
+ * :nodoc:
+ *  Initializes a message with the framed, and possibly deflated, payload. Deflated buffers are handed over to the
+ *  message without copying.
+ *
+*/
+int rb_czmq_compress_msg(zmq_compression *compression, const void *data, size_t size, zmq_msg_t *message)
+{
+    size_t length;
+    unsigned char *buffer = rb_czmq_deflate(compression, data, size, &length);
+    if (buffer) return zmq_msg_init_data(message, buffer, length, rb_czmq_compression_free, NULL);
+    if (zmq_msg_init_size(message, size + ZMQ_COMPRESSION_RAW_HEADER_SIZE) == -1) return -1;
+    buffer = zmq_msg_data(message);
+    rb_czmq_compression_header(buffer, ZMQ_COMPRESSION_FLAG_RAW);
+    memcpy(buffer + ZMQ_COMPRESSION_RAW_HEADER_SIZE, data, size);
+    return 0;
+}
+
+/*
+ * :nodoc:
+ *  Replaces the payload of an initialized message with its framed counterpart.
+ *
+*/
+int rb_czmq_compress_msg_in_place(zmq_compression *compression, zmq_msg_t *message)
+{
+    zmq_msg_t framed;
+    if (rb_czmq_compress_msg(compression, zmq_msg_data(message), zmq_msg_size(message), &framed) == -1) return -1;
+    zmq_msg_close(message);
+    return zmq_msg_move(message, &framed);
+}
+
+/*
+ * :nodoc:
+ *  Replaces the payload of a received message with the original one. Returns its size, or a negative value on error.
+ *  Drops the more flag of the message, callers check zmq_msg_more beforehand if needed.
+ *
+*/
+int rb_czmq_decompress_msg(zmq_compression *compression, zmq_msg_t *message)
+{
+    zmq_msg_t inflated;
+    const unsigned char *data = zmq_msg_data(message);
+    size_t size = zmq_msg_size(message);
+    long length;
+    if (!ZmqCompressing(compression)) return (int)size;
+    length = rb_czmq_inflated_size(data, size);
+    if (length < 0) return (int)length;
+    if (zmq_msg_init_size(&inflated, (size_t)length) == -1) return -1;
+    if (rb_czmq_inflate(data, size, zmq_msg_data(&inflated), (size_t)length) != 0) {
+        zmq_msg_close(&inflated);
+        return ZMQ_COMPRESSION_EFORMAT;
+    }
+    zmq_msg_close(message);
+    zmq_msg_move(message, &inflated);
+    return (int)length;
+}
+
+/*
+ * :nodoc:
+ *  Returns a framed copy of a frame to send in its place, or NULL if out of memory.
+ *
+*/
+zframe_t *rb_czmq_compress_frame(zmq_compression *compression, zframe_t *frame)
+{
+    zframe_t *framed = NULL;
+    size_t length, size = zframe_size(frame);
+    unsigned char *buffer = rb_czmq_deflate(compression, zframe_data(frame), size, &length);
+    if (buffer) {
+        framed = zframe_new(buffer, length);
+        free(buffer);
+        return framed;
+    }
+    framed = zframe_new(NULL, size + ZMQ_COMPRESSION_RAW_HEADER_SIZE);
+    if (framed == NULL) return NULL;
+    buffer = zframe_data(framed);
+    rb_czmq_compression_header(buffer, ZMQ_COMPRESSION_FLAG_RAW);
+    memcpy(buffer + ZMQ_COMPRESSION_RAW_HEADER_SIZE, zframe_data(frame), size);
+    return framed;
+}
+
+/*
+ * :nodoc:
+ *  Returns a frame with the original payload of a received frame, preserving its more flag. Always destroys the given
+ *  frame. Returns NULL on error, with errno set to EPROTO for malformed payloads.
+ *
+*/
+zframe_t *rb_czmq_decompress_frame(zmq_compression *compression, zframe_t *frame)
+{
+    zframe_t *inflated = NULL;
+    long length;
+    if (!ZmqCompressing(compression)) return frame;
+    length = rb_czmq_inflated_size(zframe_data(frame), zframe_size(frame));
+    if (length >= 0) inflated = zframe_new(NULL, (size_t)length);
+    if (inflated && rb_czmq_inflate(zframe_data(frame), zframe_size(frame), zframe_data(inflated), (size_t)length) != 0)
+        zframe_destroy(&inflated);
+    if (inflated) zframe_set_more(inflated, zframe_more(frame));
+    zframe_destroy(&frame);
+    return inflated;
+}
+
+/*
+ * :nodoc:
+ *  Restores the original payloads of all frames of a received message in place. Returns 0, or a negative value on
+ *  error, in which case the message may only be destroyed.
+ *
+*/
+int rb_czmq_decompress_message(zmq_compression *compression, zmsg_t *message)
+{
+    size_t i, count = zmsg_size(message);
+    zframe_t *frame = NULL;
+    if (!ZmqCompressing(compression)) return 0;
+    for (i = 0; i < count; i++) {
+        frame = rb_czmq_decompress_frame(compression, zmsg_pop(message));
+        if (frame == NULL) return errno == EPROTO ? ZMQ_COMPRESSION_EFORMAT : -1;
+        zmsg_append(message, &frame);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef RBCZMQ_COMPRESSION_H
+#define RBCZMQ_COMPRESSION_H
+
+#define ZMQ_COMPRESSION_NONE 0
+#define ZMQ_COMPRESSION_ZLIB 1
+
+/* Every payload sent by a compressing socket starts with a magic - 0xC1 never occurs in UTF-8 text nor MessagePack -
+   and a flag byte. Compressed payloads follow it with their uncompressed size as a 32 bit big endian integer. */
+#define ZMQ_COMPRESSION_MAGIC "\xC1ZC"
+#define ZMQ_COMPRESSION_MAGIC_SIZE 3
+#define ZMQ_COMPRESSION_FLAG_RAW 0x00
+#define ZMQ_COMPRESSION_FLAG_ZLIB 0x01
+#define ZMQ_COMPRESSION_RAW_HEADER_SIZE 4
+#define ZMQ_COMPRESSION_HEADER_SIZE 8
+
+#define ZMQ_COMPRESSION_DEFAULT_LEVEL 1
+#define ZMQ_COMPRESSION_DEFAULT_MIN_SIZE 1024
+
+/* Upper bound of the deflate compression ratio, used to reject forged uncompressed sizes before allocating */
+#define ZMQ_COMPRESSION_MAX_RATIO 1032
+
+/* Returned by the decompression functions, with errno set to EPROTO, for payloads not framed by a compressing peer */
+#define ZMQ_COMPRESSION_EFORMAT -2
+
+typedef struct {
+    int codec;
+    int level;
+    size_t min_size;
+} zmq_compression;
+
+#define ZmqCompressing(compression) ((compression)->codec != ZMQ_COMPRESSION_NONE)
+
+/* True if a payload of the given size gets deflated, which is worth releasing the GVL for */
+#define ZmqCompressible(compression, size) \
+    (ZmqCompressing(compression) && (size_t)(size) >= (compression)->min_size)
+
+/* All of these only use the system allocator and are safe to call without the GVL */
+int rb_czmq_compress_msg(zmq_compression *compression, const void *data, size_t size, zmq_msg_t *message);
+int rb_czmq_compress_msg_in_place(zmq_compression *compression, zmq_msg_t *message);
+int rb_czmq_decompress_msg(zmq_compression *compression, zmq_msg_t *message);
+zframe_t *rb_czmq_compress_frame(zmq_compression *compression, zframe_t *frame);
+zframe_t *rb_czmq_decompress_frame(zmq_compression *compression, zframe_t *frame);
+int rb_czmq_decompress_message(zmq_compression *compression, zmsg_t *message);
+
+#endif
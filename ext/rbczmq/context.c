@@ -59,6 +59,10 @@ static void rb_czmq_free_ctx(zmq_ctx_wrapper *ctx)
     ctx->ctx = NULL;
     rb_hash_aset(ctx_map, ctx->pidValue, Qnil);
     zlist_destroy(&ctx->sockets);
+
+    // buffers still referenced by messages in flight keep the pool alive until libzmq frees them.
+    rb_czmq_pool_release(ctx->pool);
+    ctx->pool = NULL;
 }
 
 /*
@@ -196,6 +200,7 @@ static VALUE rb_czmq_ctx_s_new(int argc, VALUE *argv, VALUE context)
     ctx->pid = getpid();
     ctx->pidValue = get_pid();
     ctx->sockets = zlist_new();
+    ctx->pool = NULL;
     ctx->file = rb_sourcefile();
     ctx->line = rb_sourceline();
     rb_obj_call_init(context, 0, NULL);
@@ -279,6 +284,85 @@ static VALUE rb_czmq_ctx_set_linger(VALUE obj, VALUE linger)
     return Qnil;
 }
 
+/*
+ *  call-seq:
+ *     ctx.buffer_pool = true    =>  nil
+ *     ctx.buffer_pool = {max_size: 16384, hugepages: true}    =>  nil
+ *     ctx.buffer_pool = nil    =>  nil
+ *
+ *  Enables or disables a pool of send buffers for all sockets of this context. Strings sent with ZMQ::Socket#send,
+ *  #sendm and friends are then copied into a recycled, size classed buffer instead of a freshly malloc'ed one, which
+ *  libzmq hands back to the pool once the message has been sent. Payloads of 64 bytes up to :max_size (default
+ *  65536, at most 1MB) are pooled. With :hugepages, slabs of buffers are allocated as 2MB regions advised to be
+ *  backed by transparent huge pages where supported. Disabling keeps buffers already allocated for reuse if the pool
+ *  is enabled again - they're only released along with the context.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     ctx.buffer_pool = {max_size: 16384}    =>   nil
+ *
+*/
+
+static VALUE rb_czmq_ctx_set_buffer_pool(VALUE obj, VALUE options)
+{
+    VALUE max_size = Qnil, hugepages = Qnil;
+    long size = ZMQ_POOL_DEFAULT_MAX_SIZE;
+    ZmqGetContext(obj);
+    ZmqAssertContextPidMatches(ctx);
+    if (NIL_P(options) || options == Qfalse) {
+        if (ctx->pool) ctx->pool->enabled = false;
+        return Qnil;
+    }
+    if (options != Qtrue) {
+        Check_Type(options, T_HASH);
+        max_size = rb_hash_aref(options, ID2SYM(rb_intern("max_size")));
+        hugepages = rb_hash_aref(options, ID2SYM(rb_intern("hugepages")));
+    }
+    if (!NIL_P(max_size)) {
+        Check_Type(max_size, T_FIXNUM);
+        size = FIX2LONG(max_size);
+        if (size < ZMQ_POOL_MIN_SIZE || size > ZMQ_POOL_MAX_SIZE)
+            rb_raise(rb_eArgError, "buffer pool max_size must be between %d and %d bytes!", ZMQ_POOL_MIN_SIZE, ZMQ_POOL_MAX_SIZE);
+    }
+    if (!ctx->pool) ctx->pool = rb_czmq_pool_new();
+    ctx->pool->max_size = (size_t)size;
+    ctx->pool->hugepages = RTEST(hugepages);
+    ctx->pool->enabled = true;
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     ctx.buffer_pool    =>  Hash or nil
+ *
+ *  Returns the settings and counters of the send buffer pool of this context, or nil if it's not enabled. :in_use is
+ *  the number of buffers held by messages in flight, :reserved the number of bytes allocated for buffers, :hits the
+ *  number of buffers recycled and :misses the number of times a new slab of buffers had to be allocated.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     ctx.buffer_pool = true
+ *     ctx.buffer_pool    =>   {:max_size=>65536, :hugepages=>false, :in_use=>0, :reserved=>0, :hits=>0, :misses=>0}
+ *
+*/
+
+static VALUE rb_czmq_ctx_buffer_pool(VALUE obj)
+{
+    VALUE stats;
+    zmq_buffer_pool *pool = NULL;
+    ZmqGetContext(obj);
+    pool = ctx->pool;
+    if (!pool || !pool->enabled) return Qnil;
+    stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("max_size")), SIZET2NUM(pool->max_size));
+    rb_hash_aset(stats, ID2SYM(rb_intern("hugepages")), pool->hugepages ? Qtrue : Qfalse);
+    rb_hash_aset(stats, ID2SYM(rb_intern("in_use")), ULONG2NUM(pool->in_use));
+    rb_hash_aset(stats, ID2SYM(rb_intern("reserved")), SIZET2NUM(rb_czmq_pool_reserved(pool)));
+    rb_hash_aset(stats, ID2SYM(rb_intern("hits")), ULONG2NUM(pool->hits));
+    rb_hash_aset(stats, ID2SYM(rb_intern("misses")), ULONG2NUM(pool->misses));
+    return rb_obj_freeze(stats);
+}
+
 /*
  * :nodoc:
  *  Creates a new socket while the GIL is released.
@@ -347,6 +431,15 @@ VALUE rb_czmq_socket_alloc(VALUE context, zctx_t *zctx, void *s)
         sock->ctx_wrapper = ctx; // rbczmq ZMQ::Context wrapped data struct
     }
     sock->verbose = false;
+    sock->fast_path = true;
+    MEMZERO(&sock->stats, zmq_sock_stats, 1);
+    sock->latency[ZMQ_LATENCY_SEND] = NULL;
+    sock->latency[ZMQ_LATENCY_RECV] = NULL;
+    sock->compression.codec = ZMQ_COMPRESSION_NONE;
+    sock->compression.level = ZMQ_COMPRESSION_DEFAULT_LEVEL;
+    sock->compression.min_size = ZMQ_COMPRESSION_DEFAULT_MIN_SIZE;
+    sock->recv_error = 0;
+    sock->registrations = NULL;
     sock->state = ZMQ_SOCKET_PENDING;
     sock->endpoints = rb_ary_new();
     sock->thread = rb_thread_current();
@@ -406,6 +499,8 @@ void _init_rb_czmq_context()
     rb_define_method(rb_cZmqContext, "destroy", rb_czmq_ctx_destroy, 0);
     rb_define_method(rb_cZmqContext, "iothreads=", rb_czmq_ctx_set_iothreads, 1);
     rb_define_method(rb_cZmqContext, "linger=", rb_czmq_ctx_set_linger, 1);
+    rb_define_method(rb_cZmqContext, "buffer_pool=", rb_czmq_ctx_set_buffer_pool, 1);
+    rb_define_method(rb_cZmqContext, "buffer_pool", rb_czmq_ctx_buffer_pool, 0);
     rb_define_method(rb_cZmqContext, "socket", rb_czmq_ctx_socket, 1);
 
     context_mutex = zmutex_new();
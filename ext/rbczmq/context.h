@@ -13,6 +13,7 @@ typedef struct {
     const char *file; /* Source file where the context for this process was created */
     int line; /* Source line where the context for this process was created */
     zlist_t* sockets; /* list of socket wrapper objects owned by this context. */
+    zmq_buffer_pool *pool; /* send buffer pool, NULL unless enabled through ZMQ::Context#buffer_pool= */
 } zmq_ctx_wrapper;
 
 #define ZmqAssertContext(obj) ZmqAssertType(obj, rb_cZmqContext, "ZMQ::Context")
@@ -140,8 +140,12 @@ end
 dir_config('rbczmq')
 
 have_header('ruby/thread.h')
+have_header('sys/epoll.h')
 have_func('rb_thread_blocking_region')
 have_func('rb_thread_call_without_gvl')
+have_func('rb_thread_call_without_gvl2')
+have_func('rb_str_new_static')
+have_library('z', 'compress2', 'zlib.h')
 
 $INCFLAGS << " -I#{libsodium_include_path}" if find_header("sodidum.h", libsodium_include_path)
 $INCFLAGS << " -I#{zmq_include_path}" if find_header("zmq.h", zmq_include_path)
@@ -15,6 +15,7 @@ VALUE rb_czmq_alloc_frame(zframe_t *frame)
     f->frame = frame;
     f->flags = ZMQ_FRAME_OWNED;
     f->message = NULL;
+    f->share = NULL;
     rb_obj_call_init(frame_obj, 0, NULL);
     return frame_obj;
 }
@@ -33,6 +34,7 @@ void rb_czmq_free_frame(zmq_frame_wrapper *frame)
         frame->flags &= ~ZMQ_FRAME_OWNED;
     }
     frame->frame = NULL;
+    frame->share = NULL;
 }
 
 /*
@@ -55,6 +57,7 @@ void rb_czmq_free_frame_gc(void *ptr)
  *     ZMQ::Frame.new("data")    =>  ZMQ::Frame
  *
  *  Creates a new ZMQ::Frame instance. Can be initialized with or without data. A frame corresponds to one zmq_msg_t.
+ *  Frozen Strings of at least ZMQ.zero_copy_threshold bytes are referenced by the frame instead of copied.
  *
  * === Examples
  *     ZMQ::Frame.new    =>  ZMQ::Frame
@@ -67,12 +70,22 @@ static VALUE rb_czmq_frame_s_new(int argc, VALUE *argv, VALUE frame)
     VALUE data;
     errno = 0;
     zframe_t *fr;
+    zmq_zero_copy_pin *pin = NULL;
     rb_scan_args(argc, argv, "01", &data);
     if (NIL_P(data)) {
         fr = zframe_new(NULL, 0);
     } else {
         Check_Type(data, T_STRING);
-        fr = zframe_new(RSTRING_PTR(data), (size_t)RSTRING_LEN(data));
+        pin = rb_czmq_zero_copy_pin(data);
+        if (pin) {
+            ZmqAtomicIncrement(pin->refs);
+            fr = zframe_new_zero_copy(RSTRING_PTR(data), (size_t)RSTRING_LEN(data), rb_czmq_zero_copy_free, pin);
+            /* libzmq never took a reference */
+            if (fr == NULL) ZmqAtomicDecrement(pin->refs);
+            rb_czmq_zero_copy_unpin(pin);
+        } else {
+            fr = zframe_new(RSTRING_PTR(data), (size_t)RSTRING_LEN(data));
+        }
     }
     if (fr == NULL) {
         ZmqAssertSysError();
@@ -145,6 +158,26 @@ static VALUE rb_czmq_frame_data(VALUE obj)
     return ZmqEncode(rb_str_new((char *)zframe_data(frame->frame), (long)size));
 }
 
+/*
+ *  call-seq:
+ *     frame.unpack_msgpack    =>  Object
+ *
+ *  Decodes the frame data as a single MessagePack object, directly from the frame buffer. Raises ZMQ::Error if the
+ *  data isn't valid MessagePack. See ZMQ::Socket#send_packed for supported types.
+ *
+ * === Examples
+ *     frame = ZMQ::Frame.new("\x92\x01\xA1a")    =>  ZMQ::Frame
+ *     frame.unpack_msgpack     =>  [1, "a"]
+ *
+*/
+
+static VALUE rb_czmq_frame_unpack_msgpack(VALUE obj)
+{
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    return rb_czmq_msgpack_unpack(zframe_data(frame->frame), zframe_size(frame->frame));
+}
+
 /*
  *  call-seq:
  *     frame.to_s    =>  String
@@ -270,6 +303,25 @@ static VALUE rb_czmq_frame_eql_p(VALUE obj, VALUE other_frame)
     return (zframe_eq(frame->frame, other->frame)) ? Qtrue : Qfalse;
 }
 
+/*
+ *  call-seq:
+ *     frame.hash    =>  Fixnum
+ *
+ *  Returns a hash of the frame data, consistent with ZMQ::Frame#eql? - frames can be used as Hash keys.
+ *
+ * === Examples
+ *     frame = ZMQ::Frame.new("message")    =>  ZMQ::Frame
+ *     frame.hash == ZMQ::Frame.new("message").hash    =>  true
+ *
+*/
+
+static VALUE rb_czmq_frame_hash(VALUE obj)
+{
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    return ZmqHash2Fix(rb_czmq_hash(zframe_data(frame->frame), zframe_size(frame->frame), 0));
+}
+
 /*
  *  call-seq:
  *     frame == other    =>  boolean
@@ -369,10 +421,238 @@ static VALUE rb_czmq_frame_reset(VALUE obj, VALUE data)
     ZmqAssertFrameOwned(frame);
     Check_Type(data, T_STRING);
     zframe_reset(frame->frame, (char *)RSTRING_PTR(data), (size_t)RSTRING_LEN(data));
+    /* no longer a view of shared data */
+    frame->share = NULL;
     ZmqAssertSysError();
     return Qnil;
 }
 
+/*
+ * :nodoc:
+ *  libzmq deallocation callback for views of a shared frame. May be invoked from any thread, without the GVL.
+ *
+*/
+static void rb_czmq_frame_share_free(ZMQ_UNUSED void *data, void *hint)
+{
+    zmq_frame_share *share = (zmq_frame_share *)hint;
+    if (ZmqAtomicDecrement(share->refs) == 0) {
+        zframe_destroy(&share->frame);
+        free(share);
+    }
+}
+
+/*
+ * :nodoc:
+ *  Creates a zero-copy view of a region of a shared frame.
+ *
+*/
+static zframe_t *rb_czmq_frame_share_view(zmq_frame_share *share, byte *data, size_t size)
+{
+    zframe_t *view = NULL;
+    ZmqAtomicIncrement(share->refs);
+    view = zframe_new_zero_copy(data, size, rb_czmq_frame_share_free, share);
+    if (view == NULL) {
+        ZmqAtomicDecrement(share->refs);
+        rb_memerror();
+    }
+    return view;
+}
+
+/*
+ * :nodoc:
+ *  Returns the shared frame backing this frame, moving the frame's data into one on first use : the original zframe
+ *  is handed over to the share, and replaced by a zero-copy view of it - in its message as well, if any. No data is
+ *  copied.
+ *
+*/
+static zmq_frame_share *rb_czmq_frame_share(zmq_frame_wrapper *frame)
+{
+    zmq_frame_share *share = NULL;
+    zframe_t *view = NULL;
+    if (frame->share) return frame->share;
+    share = (zmq_frame_share *)malloc(sizeof(zmq_frame_share));
+    if (!share) rb_memerror();
+    share->frame = frame->frame;
+    share->refs = 0;
+    view = rb_czmq_frame_share_view(share, zframe_data(share->frame), zframe_size(share->frame));
+    zframe_set_more(view, zframe_more(share->frame));
+    if (frame->message) rb_czmq_message_replace_frame(frame->message, share->frame, view);
+    frame->frame = view;
+    frame->share = share;
+    return share;
+}
+
+/*
+ *  call-seq:
+ *     frame.slice(offset, length)   =>  ZMQ::Frame or nil
+ *
+ *  Returns a frame for length bytes of this frame's data, starting at offset, without copying them. The slice and this
+ *  frame share the same buffer, which is released once both are gone - slices can thus be sent or added to messages
+ *  like any other frame, and outlive the frame they were sliced from. A negative offset counts backwards from the end,
+ *  and length is capped at the end of the data. Returns nil if offset or length are out of range.
+ *
+ * === Examples
+ *     frame = ZMQ::Frame.new("headerbody")    =>  ZMQ::Frame
+ *     body = frame.slice(6, 4)    =>  ZMQ::Frame
+ *     body.to_s   =>   "body"
+ *     sock.send_frame(body)
+ *
+*/
+
+static VALUE rb_czmq_frame_slice(VALUE obj, VALUE offset, VALUE length)
+{
+    long off, len, size;
+    zmq_frame_share *share = NULL;
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    off = NUM2LONG(offset);
+    len = NUM2LONG(length);
+    size = (long)zframe_size(frame->frame);
+    if (off < 0) off += size;
+    if (off < 0 || off > size || len < 0) return Qnil;
+    if (len > size - off) len = size - off;
+    /* libzmq never calls back for empty zero-copy frames, which would leak the share : copy nothing instead */
+    if (len == 0) return rb_czmq_alloc_frame(zframe_new(NULL, 0));
+    share = rb_czmq_frame_share(frame);
+    {
+        VALUE slice_obj = rb_czmq_alloc_frame(rb_czmq_frame_share_view(share, zframe_data(frame->frame) + off, (size_t)len));
+        zmq_frame_wrapper *slice = NULL;
+        Data_Get_Struct(slice_obj, zmq_frame_wrapper, slice);
+        slice->share = share;
+        return slice_obj;
+    }
+}
+
+/*
+ * :nodoc:
+ *  Coerces a 1 to 8 byte wide number at a given location to a Ruby Integer or Float.
+ *
+*/
+VALUE rb_czmq_num_load(const unsigned char *ptr, int width, int kind, bool big_endian)
+{
+    uint64_t value = rb_czmq_load(ptr, width, big_endian);
+    int shift = 64 - width * 8;
+    if (kind == ZMQ_NUM_FLOAT) {
+        if (width == 4) {
+            uint32_t bits = (uint32_t)value;
+            float f;
+            memcpy(&f, &bits, 4);
+            return rb_float_new((double)f);
+        } else {
+            double d;
+            memcpy(&d, &value, 8);
+            return rb_float_new(d);
+        }
+    }
+    if (kind == ZMQ_NUM_SIGNED) return LL2NUM((int64_t)(value << shift) >> shift);
+    return ULL2NUM(value);
+}
+
+/*
+ * :nodoc:
+ *  Stores a Ruby number as a 1 to 8 byte wide number at a given location. Integers are truncated to the given width,
+ *  as with Array#pack.
+ *
+*/
+void rb_czmq_num_store(unsigned char *ptr, VALUE value, int width, int kind, bool big_endian)
+{
+    uint64_t bits;
+    if (kind == ZMQ_NUM_FLOAT) {
+        if (width == 4) {
+            float f = (float)NUM2DBL(value);
+            uint32_t b;
+            memcpy(&b, &f, 4);
+            bits = b;
+        } else {
+            double d = NUM2DBL(value);
+            memcpy(&bits, &d, 8);
+        }
+    } else if (kind == ZMQ_NUM_SIGNED || (FIXNUM_P(value) && FIX2LONG(value) < 0)) {
+        bits = (uint64_t)NUM2LL(value);
+    } else {
+        bits = NUM2ULL(value);
+    }
+    rb_czmq_store(ptr, bits, width, big_endian);
+}
+
+/*
+ * :nodoc:
+ *  Returns a pointer to width bytes at a given offset of the frame data, raising IndexError if out of bounds.
+ *
+*/
+static unsigned char *rb_czmq_frame_at(zmq_frame_wrapper *frame, VALUE offset, int width)
+{
+    long off = NUM2LONG(offset);
+    long size = (long)zframe_size(frame->frame);
+    if (off < 0 || off > size - width)
+        rb_raise(rb_eIndexError, "offset %ld out of range for a %d byte value in a %ld byte frame", off, width, size);
+    return (unsigned char *)zframe_data(frame->frame) + off;
+}
+
+static VALUE rb_czmq_frame_read(VALUE obj, VALUE offset, int width, int kind, bool big_endian)
+{
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    return rb_czmq_num_load(rb_czmq_frame_at(frame, offset, width), width, kind, big_endian);
+}
+
+static VALUE rb_czmq_frame_write(VALUE obj, VALUE offset, VALUE value, int width, int kind, bool big_endian)
+{
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    /* zero-copy frames reference frozen Strings or data shared with slices */
+    if (zframe_zero_copy(frame->frame)) rb_raise(rb_eZmqError, "cannot write to a zero-copy or sliced frame!");
+    rb_czmq_num_store(rb_czmq_frame_at(frame, offset, width), value, width, kind, big_endian);
+    return Qnil;
+}
+
+/*
+ *  Typed accessors : frame.read_<type>(offset) and frame.write_<type>(offset, value) for u8, i8 and u16, i16, u32,
+ *  i32, u64, i64, f32, f64 suffixed with be (big endian) or le (little endian). They work on the frame data in place,
+ *  without intermediate Strings, and raise IndexError for values that don't fit the frame. Writers raise ZMQ::Error
+ *  for zero-copy frames, which don't own their data.
+ *
+ * === Examples
+ *     frame = ZMQ::Frame.new("\x00\x00\x00\x2A\xFF")    =>  ZMQ::Frame
+ *     frame.read_u32be(0)    =>  42
+ *     frame.read_i8(4)    =>  -1
+ *     frame.write_u16le(0, 7)    =>  nil
+ *
+*/
+
+#define ZmqFrameAccessors(name, width, kind, big_endian) \
+    static VALUE rb_czmq_frame_read_##name(VALUE obj, VALUE offset) \
+    { \
+        return rb_czmq_frame_read(obj, offset, width, kind, big_endian); \
+    } \
+    static VALUE rb_czmq_frame_write_##name(VALUE obj, VALUE offset, VALUE value) \
+    { \
+        return rb_czmq_frame_write(obj, offset, value, width, kind, big_endian); \
+    }
+
+ZmqFrameAccessors(u8, 1, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameAccessors(i8, 1, ZMQ_NUM_SIGNED, true)
+ZmqFrameAccessors(u16be, 2, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameAccessors(u16le, 2, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameAccessors(i16be, 2, ZMQ_NUM_SIGNED, true)
+ZmqFrameAccessors(i16le, 2, ZMQ_NUM_SIGNED, false)
+ZmqFrameAccessors(u32be, 4, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameAccessors(u32le, 4, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameAccessors(i32be, 4, ZMQ_NUM_SIGNED, true)
+ZmqFrameAccessors(i32le, 4, ZMQ_NUM_SIGNED, false)
+ZmqFrameAccessors(u64be, 8, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameAccessors(u64le, 8, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameAccessors(i64be, 8, ZMQ_NUM_SIGNED, true)
+ZmqFrameAccessors(i64le, 8, ZMQ_NUM_SIGNED, false)
+ZmqFrameAccessors(f32be, 4, ZMQ_NUM_FLOAT, true)
+ZmqFrameAccessors(f32le, 4, ZMQ_NUM_FLOAT, false)
+ZmqFrameAccessors(f64be, 8, ZMQ_NUM_FLOAT, true)
+ZmqFrameAccessors(f64le, 8, ZMQ_NUM_FLOAT, false)
+
+#define ZmqDefineFrameAccessors(name) \
+    rb_define_method(rb_cZmqFrame, "read_" #name, rb_czmq_frame_read_##name, 1); \
+    rb_define_method(rb_cZmqFrame, "write_" #name, rb_czmq_frame_write_##name, 2);
+
 /*
  * call-seq:
  *    frame.gone?   #=> false
@@ -408,6 +688,7 @@ void _init_rb_czmq_frame()
     rb_define_method(rb_cZmqFrame, "size", rb_czmq_frame_size, 0);
     rb_define_method(rb_cZmqFrame, "dup", rb_czmq_frame_dup, 0);
     rb_define_method(rb_cZmqFrame, "data", rb_czmq_frame_data, 0);
+    rb_define_method(rb_cZmqFrame, "unpack_msgpack", rb_czmq_frame_unpack_msgpack, 0);
     rb_define_method(rb_cZmqFrame, "to_s", rb_czmq_frame_to_s, 0);
     rb_define_method(rb_cZmqFrame, "to_str", rb_czmq_frame_to_s, 0);
     rb_define_method(rb_cZmqFrame, "strhex", rb_czmq_frame_strhex, 0);
@@ -415,9 +696,30 @@ void _init_rb_czmq_frame()
     rb_define_method(rb_cZmqFrame, "more?", rb_czmq_frame_more_p, 0);
     rb_define_method(rb_cZmqFrame, "eql?", rb_czmq_frame_eql_p, 1);
     rb_define_method(rb_cZmqFrame, "==", rb_czmq_frame_equals, 1);
+    rb_define_method(rb_cZmqFrame, "hash", rb_czmq_frame_hash, 0);
     rb_define_method(rb_cZmqFrame, "<=>", rb_czmq_frame_cmp, 1);
     rb_define_method(rb_cZmqFrame, "print", rb_czmq_frame_print, -1);
     rb_define_alias(rb_cZmqFrame, "dump", "print");
     rb_define_method(rb_cZmqFrame, "reset", rb_czmq_frame_reset, 1);
+    rb_define_method(rb_cZmqFrame, "slice", rb_czmq_frame_slice, 2);
+
+    ZmqDefineFrameAccessors(u8);
+    ZmqDefineFrameAccessors(i8);
+    ZmqDefineFrameAccessors(u16be);
+    ZmqDefineFrameAccessors(u16le);
+    ZmqDefineFrameAccessors(i16be);
+    ZmqDefineFrameAccessors(i16le);
+    ZmqDefineFrameAccessors(u32be);
+    ZmqDefineFrameAccessors(u32le);
+    ZmqDefineFrameAccessors(i32be);
+    ZmqDefineFrameAccessors(i32le);
+    ZmqDefineFrameAccessors(u64be);
+    ZmqDefineFrameAccessors(u64le);
+    ZmqDefineFrameAccessors(i64be);
+    ZmqDefineFrameAccessors(i64le);
+    ZmqDefineFrameAccessors(f32be);
+    ZmqDefineFrameAccessors(f32le);
+    ZmqDefineFrameAccessors(f64be);
+    ZmqDefineFrameAccessors(f64le);
     rb_define_method(rb_cZmqFrame, "gone?", rb_czmq_frame_gone, 0);
 }
@@ -7,6 +7,13 @@
    and can be freed when the ZMQ::Frame object is garbage collected */
 #define ZMQ_FRAME_OWNED 0x01
 
+/* A frame whose data is shared by zero-copy views - the frame it was sliced from and all slices. Released, possibly
+   from a libzmq I/O thread, once the last view is gone. */
+typedef struct {
+    zframe_t *frame;
+    volatile unsigned long refs;
+} zmq_frame_share;
+
 typedef struct {
     /* The czmq frame object. This is only valid if the frame is owned
        by ruby, or the frame has been added to a message and the message
@@ -17,6 +24,9 @@ typedef struct {
     zmq_message_wrapper* message;
 
     int flags;
+
+    /* The shared frame this frame is a zero-copy view of, if sliced, or NULL */
+    zmq_frame_share *share;
 } zmq_frame_wrapper;
 
 #define ZmqAssertFrame(obj) ZmqAssertType(obj, rb_cZmqFrame, "ZMQ::Frame")
@@ -46,11 +56,44 @@ typedef struct {
         return Qnil; \
     }
 
+/* Numeric kinds for the typed frame accessors */
+#define ZMQ_NUM_UNSIGNED 0
+#define ZMQ_NUM_SIGNED 1
+#define ZMQ_NUM_FLOAT 2
+
+/* Byte order agnostic loads and stores of 1 to 8 byte wide values. Compilers turn these into plain (byte swapped)
+   moves for constant widths, without alignment requirements. */
+static inline uint64_t rb_czmq_load(const unsigned char *ptr, int width, bool big_endian)
+{
+    uint64_t value = 0;
+    int i;
+    if (big_endian) {
+        for (i = 0; i < width; i++) value = (value << 8) | ptr[i];
+    } else {
+        for (i = width - 1; i >= 0; i--) value = (value << 8) | ptr[i];
+    }
+    return value;
+}
+
+static inline void rb_czmq_store(unsigned char *ptr, uint64_t value, int width, bool big_endian)
+{
+    int i;
+    if (big_endian) {
+        for (i = width - 1; i >= 0; i--, value >>= 8) ptr[i] = (unsigned char)value;
+    } else {
+        for (i = 0; i < width; i++, value >>= 8) ptr[i] = (unsigned char)value;
+    }
+}
+
+VALUE rb_czmq_num_load(const unsigned char *ptr, int width, int kind, bool big_endian);
+void rb_czmq_num_store(unsigned char *ptr, VALUE value, int width, int kind, bool big_endian);
+
 void rb_czmq_free_frame(zmq_frame_wrapper *frame);
 void rb_czmq_free_frame_gc(void *ptr);
 
 VALUE rb_czmq_alloc_frame(zframe_t *frame);
 
 void _init_rb_czmq_frame();
+void _init_rb_czmq_frame_numeric();
 
 #endif
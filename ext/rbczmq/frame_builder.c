@@ -0,0 +1,169 @@
+#include "rbczmq_ext.h"
+
+/*
+ * :nodoc:
+ *  GC free callback
+ *
+*/
+static void rb_czmq_free_frame_builder_gc(void *ptr)
+{
+    zmq_frame_builder *builder = (zmq_frame_builder *)ptr;
+    if (builder) {
+        if (builder->data) xfree(builder->data);
+        xfree(builder);
+    }
+}
+
+/*
+ * :nodoc:
+ *  Reserves room for length more bytes and returns a pointer to them.
+ *
+*/
+static unsigned char *rb_czmq_frame_builder_reserve(zmq_frame_builder *builder, size_t length)
+{
+    unsigned char *ptr = NULL;
+    if (builder->size + length > builder->capa) {
+        while (builder->size + length > builder->capa) builder->capa *= 2;
+        REALLOC_N(builder->data, unsigned char, builder->capa);
+    }
+    ptr = builder->data + builder->size;
+    builder->size += length;
+    return ptr;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Frame.build { |builder| ... }    =>  ZMQ::Frame
+ *
+ *  Builds a frame from binary fields appended to the yielded ZMQ::Frame::Builder : u8, i8 and u16, i16, u32, i32,
+ *  u64, i64, f32, f64 - in network byte order (big endian) or with an explicit be / le suffix - and bytes for Strings.
+ *  All builder methods return the builder and can thus be chained.
+ *
+ * === Examples
+ *     frame = ZMQ::Frame.build do |b|
+ *       b.u64(seq)
+ *       b.u16le(flags)
+ *       b.bytes(payload)
+ *     end    =>  ZMQ::Frame
+ *
+*/
+
+static VALUE rb_czmq_frame_s_build(ZMQ_UNUSED VALUE obj)
+{
+    VALUE builder_obj;
+    zmq_frame_builder *builder = NULL;
+    zframe_t *frame = NULL;
+    builder_obj = Data_Make_Struct(rb_cZmqFrameBuilder, zmq_frame_builder, 0, rb_czmq_free_frame_builder_gc, builder);
+    builder->capa = ZMQ_FRAME_BUILDER_INITIAL_CAPA;
+    builder->data = ALLOC_N(unsigned char, builder->capa);
+    builder->size = 0;
+    builder->built = false;
+    rb_yield(builder_obj);
+    builder->built = true;
+    frame = zframe_new(builder->data, builder->size);
+    if (frame == NULL) {
+        ZmqAssertSysError();
+        rb_memerror();
+    }
+    return rb_czmq_alloc_frame(frame);
+}
+
+/*
+ *  call-seq:
+ *     builder.bytes("data")    =>  ZMQ::Frame::Builder
+ *
+ *  Appends the bytes of a String.
+ *
+ * === Examples
+ *     ZMQ::Frame.build { |b| b.bytes("data") }    =>  ZMQ::Frame
+ *
+*/
+
+static VALUE rb_czmq_frame_builder_bytes(VALUE obj, VALUE str)
+{
+    ZmqGetFrameBuilder(obj);
+    Check_Type(str, T_STRING);
+    MEMCPY(rb_czmq_frame_builder_reserve(builder, RSTRING_LEN(str)), RSTRING_PTR(str), char, RSTRING_LEN(str));
+    return obj;
+}
+
+/*
+ *  call-seq:
+ *     builder.size    =>  Fixnum
+ *
+ *  Returns the number of bytes appended so far.
+ *
+ * === Examples
+ *     ZMQ::Frame.build { |b| b.u32(1); b.size    =>  4 }
+ *
+*/
+
+static VALUE rb_czmq_frame_builder_size(VALUE obj)
+{
+    ZmqGetFrameBuilder(obj);
+    return SIZET2NUM(builder->size);
+}
+
+static VALUE rb_czmq_frame_builder_append(VALUE obj, VALUE value, int width, int kind, bool big_endian)
+{
+    ZmqGetFrameBuilder(obj);
+    /* convert first - a failed conversion must not leave a gap */
+    {
+        unsigned char field[8];
+        rb_czmq_num_store(field, value, width, kind, big_endian);
+        MEMCPY(rb_czmq_frame_builder_reserve(builder, width), field, unsigned char, width);
+    }
+    return obj;
+}
+
+#define ZmqFrameBuilderAppender(name, width, kind, big_endian) \
+    static VALUE rb_czmq_frame_builder_##name(VALUE obj, VALUE value) \
+    { \
+        return rb_czmq_frame_builder_append(obj, value, width, kind, big_endian); \
+    }
+
+ZmqFrameBuilderAppender(u8, 1, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameBuilderAppender(i8, 1, ZMQ_NUM_SIGNED, true)
+ZmqFrameBuilderAppender(u16be, 2, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameBuilderAppender(u16le, 2, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameBuilderAppender(i16be, 2, ZMQ_NUM_SIGNED, true)
+ZmqFrameBuilderAppender(i16le, 2, ZMQ_NUM_SIGNED, false)
+ZmqFrameBuilderAppender(u32be, 4, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameBuilderAppender(u32le, 4, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameBuilderAppender(i32be, 4, ZMQ_NUM_SIGNED, true)
+ZmqFrameBuilderAppender(i32le, 4, ZMQ_NUM_SIGNED, false)
+ZmqFrameBuilderAppender(u64be, 8, ZMQ_NUM_UNSIGNED, true)
+ZmqFrameBuilderAppender(u64le, 8, ZMQ_NUM_UNSIGNED, false)
+ZmqFrameBuilderAppender(i64be, 8, ZMQ_NUM_SIGNED, true)
+ZmqFrameBuilderAppender(i64le, 8, ZMQ_NUM_SIGNED, false)
+ZmqFrameBuilderAppender(f32be, 4, ZMQ_NUM_FLOAT, true)
+ZmqFrameBuilderAppender(f32le, 4, ZMQ_NUM_FLOAT, false)
+ZmqFrameBuilderAppender(f64be, 8, ZMQ_NUM_FLOAT, true)
+ZmqFrameBuilderAppender(f64le, 8, ZMQ_NUM_FLOAT, false)
+
+/* Wider fields default to network byte order */
+#define ZmqDefineFrameBuilderAppenders(name) \
+    rb_define_method(rb_cZmqFrameBuilder, #name, rb_czmq_frame_builder_##name##be, 1); \
+    rb_define_method(rb_cZmqFrameBuilder, #name "be", rb_czmq_frame_builder_##name##be, 1); \
+    rb_define_method(rb_cZmqFrameBuilder, #name "le", rb_czmq_frame_builder_##name##le, 1);
+
+void _init_rb_czmq_frame_builder()
+{
+    rb_cZmqFrameBuilder = rb_define_class_under(rb_cZmqFrame, "Builder", rb_cObject);
+    rb_undef_alloc_func(rb_cZmqFrameBuilder);
+
+    rb_define_singleton_method(rb_cZmqFrame, "build", rb_czmq_frame_s_build, 0);
+
+    rb_define_method(rb_cZmqFrameBuilder, "bytes", rb_czmq_frame_builder_bytes, 1);
+    rb_define_method(rb_cZmqFrameBuilder, "size", rb_czmq_frame_builder_size, 0);
+    rb_define_method(rb_cZmqFrameBuilder, "u8", rb_czmq_frame_builder_u8, 1);
+    rb_define_method(rb_cZmqFrameBuilder, "i8", rb_czmq_frame_builder_i8, 1);
+    ZmqDefineFrameBuilderAppenders(u16);
+    ZmqDefineFrameBuilderAppenders(i16);
+    ZmqDefineFrameBuilderAppenders(u32);
+    ZmqDefineFrameBuilderAppenders(i32);
+    ZmqDefineFrameBuilderAppenders(u64);
+    ZmqDefineFrameBuilderAppenders(i64);
+    ZmqDefineFrameBuilderAppenders(f32);
+    ZmqDefineFrameBuilderAppenders(f64);
+}
@@ -0,0 +1,24 @@
+#ifndef RBCZMQ_FRAME_BUILDER_H
+#define RBCZMQ_FRAME_BUILDER_H
+
+#define ZMQ_FRAME_BUILDER_INITIAL_CAPA 64
+
+/* Growable buffer ZMQ::Frame.build appends fields to before creating the frame */
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capa;
+    bool built;
+} zmq_frame_builder;
+
+#define ZmqAssertFrameBuilder(obj) ZmqAssertType(obj, rb_cZmqFrameBuilder, "ZMQ::Frame::Builder")
+#define ZmqGetFrameBuilder(obj) \
+    zmq_frame_builder *builder = NULL; \
+    ZmqAssertFrameBuilder(obj); \
+    Data_Get_Struct(obj, zmq_frame_builder, builder); \
+    if (!builder) rb_raise(rb_eTypeError, "uninitialized ZMQ frame builder!"); \
+    if (builder->built) rb_raise(rb_eZmqError, "frame has already been built!");
+
+void _init_rb_czmq_frame_builder();
+
+#endif
@@ -0,0 +1,305 @@
+#include "rbczmq_ext.h"
+
+static VALUE sym_double;
+static VALUE sym_int64;
+
+/* Frame payloads are arrays of little endian 64 bit values - in native byte order on most hosts, which lets the
+   compiler vectorize the loops below. Loads and stores go through memcpy as frame data isn't necessarily aligned. */
+#ifdef WORDS_BIGENDIAN
+#define ZmqLoad64(ptr) rb_czmq_load((const unsigned char *)(ptr), 8, false)
+#define ZmqStore64(ptr, bits) rb_czmq_store((unsigned char *)(ptr), (bits), 8, false)
+#else
+static inline uint64_t rb_czmq_load64(const unsigned char *ptr)
+{
+    uint64_t bits;
+    memcpy(&bits, ptr, 8);
+    return bits;
+}
+#define ZmqLoad64(ptr) rb_czmq_load64((const unsigned char *)(ptr))
+#define ZmqStore64(ptr, bits) \
+  do { \
+      uint64_t stored = (bits); \
+      memcpy((ptr), &stored, 8); \
+  } while(0)
+#endif
+
+static inline double rb_czmq_load_double(const unsigned char *ptr)
+{
+    uint64_t bits = ZmqLoad64(ptr);
+    double value;
+    memcpy(&value, &bits, 8);
+    return value;
+}
+
+/*
+ * :nodoc:
+ *  Maps an element type Symbol to its kind - ZMQ_NUM_FLOAT for :double or nil, ZMQ_NUM_SIGNED for :int64.
+ *
+*/
+static int rb_czmq_frame_numeric_kind(VALUE type)
+{
+    if (NIL_P(type) || type == sym_double) return ZMQ_NUM_FLOAT;
+    if (type == sym_int64) return ZMQ_NUM_SIGNED;
+    rb_raise(rb_eArgError, "unsupported element type, expected :double or :int64");
+    return -1;
+}
+
+/*
+ * :nodoc:
+ *  Returns the number of 64 bit elements in a frame, raising ArgumentError if its size is not a multiple of 8.
+ *
+*/
+static long rb_czmq_frame_numeric_count(zmq_frame_wrapper *frame)
+{
+    size_t size = zframe_size(frame->frame);
+    if (size % 8 != 0) rb_raise(rb_eArgError, "frame size %lu is not a multiple of 8 bytes", (unsigned long)size);
+    return (long)(size / 8);
+}
+
+/*
+ * :nodoc:
+ *  Creates a frame of 8 byte elements from an Array, converting the elements straight into the frame buffer.
+ *  Conversions may call back into Ruby, so elements are fetched one at a time and the Array is checked for changes.
+ *
+*/
+static VALUE rb_czmq_frame_from_array(VALUE array, int kind)
+{
+    long i, count;
+    zframe_t *zframe = NULL;
+    unsigned char *ptr = NULL;
+    VALUE element;
+    Check_Type(array, T_ARRAY);
+    count = RARRAY_LEN(array);
+    zframe = zframe_new(NULL, (size_t)count * 8);
+    if (zframe == NULL) {
+        ZmqAssertSysError();
+        rb_memerror();
+    }
+    /* the frame is owned by its Ruby object before any conversion may raise */
+    VALUE frame_obj = rb_czmq_alloc_frame(zframe);
+    ptr = zframe_data(zframe);
+    for (i = 0; i < count; i++, ptr += 8) {
+        if (RARRAY_LEN(array) != count) rb_raise(rb_eRuntimeError, "array modified during conversion");
+        element = rb_ary_entry(array, i);
+        if (kind == ZMQ_NUM_FLOAT) {
+            double value = NUM2DBL(element);
+            uint64_t bits;
+            memcpy(&bits, &value, 8);
+            ZmqStore64(ptr, bits);
+        } else {
+            ZmqStore64(ptr, (uint64_t)NUM2LL(element));
+        }
+    }
+    return frame_obj;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Frame.from_doubles([1.5, 2.0])    =>  ZMQ::Frame
+ *
+ *  Creates a frame of little endian 64 bit floats from an Array of numbers, in one pass and without an intermediate
+ *  String. The counterpart of ZMQ::Frame#to_doubles.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_doubles([1.5, 2.0]).size    =>  16
+ *
+*/
+
+static VALUE rb_czmq_frame_s_from_doubles(ZMQ_UNUSED VALUE obj, VALUE array)
+{
+    return rb_czmq_frame_from_array(array, ZMQ_NUM_FLOAT);
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Frame.from_int64s([1, -2])    =>  ZMQ::Frame
+ *
+ *  Creates a frame of little endian 64 bit signed integers from an Array of Integers, in one pass and without an
+ *  intermediate String. The counterpart of ZMQ::Frame#to_int64s.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_int64s([1, -2]).size    =>  16
+ *
+*/
+
+static VALUE rb_czmq_frame_s_from_int64s(ZMQ_UNUSED VALUE obj, VALUE array)
+{
+    return rb_czmq_frame_from_array(array, ZMQ_NUM_SIGNED);
+}
+
+/*
+ *  call-seq:
+ *     frame.to_doubles    =>  Array
+ *
+ *  Returns the frame data as an Array of Floats, reading little endian 64 bit floats. Raises ArgumentError if the
+ *  frame size is not a multiple of 8.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_doubles([1.5, 2.0]).to_doubles    =>  [1.5, 2.0]
+ *
+*/
+
+static VALUE rb_czmq_frame_to_doubles(VALUE obj)
+{
+    long i, count;
+    const unsigned char *ptr = NULL;
+    VALUE array;
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    count = rb_czmq_frame_numeric_count(frame);
+    array = rb_ary_new2(count);
+    ptr = zframe_data(frame->frame);
+    for (i = 0; i < count; i++, ptr += 8) rb_ary_push(array, rb_float_new(rb_czmq_load_double(ptr)));
+    return array;
+}
+
+/*
+ *  call-seq:
+ *     frame.to_int64s    =>  Array
+ *
+ *  Returns the frame data as an Array of Integers, reading little endian 64 bit signed integers. Raises ArgumentError
+ *  if the frame size is not a multiple of 8.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_int64s([1, -2]).to_int64s    =>  [1, -2]
+ *
+*/
+
+static VALUE rb_czmq_frame_to_int64s(VALUE obj)
+{
+    long i, count;
+    const unsigned char *ptr = NULL;
+    VALUE array;
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    count = rb_czmq_frame_numeric_count(frame);
+    array = rb_ary_new2(count);
+    ptr = zframe_data(frame->frame);
+    for (i = 0; i < count; i++, ptr += 8) rb_ary_push(array, LL2NUM((int64_t)ZmqLoad64(ptr)));
+    return array;
+}
+
+/*
+ * :nodoc:
+ *  Sums little endian doubles with 4 independent accumulators, which breaks the dependency chain and lets the
+ *  compiler keep the running sums in SIMD registers.
+ *
+*/
+static double rb_czmq_sum_doubles(const unsigned char *ptr, long count)
+{
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    long i = 0;
+    for (; i + 4 <= count; i += 4, ptr += 32) {
+        acc[0] += rb_czmq_load_double(ptr);
+        acc[1] += rb_czmq_load_double(ptr + 8);
+        acc[2] += rb_czmq_load_double(ptr + 16);
+        acc[3] += rb_czmq_load_double(ptr + 24);
+    }
+    for (; i < count; i++, ptr += 8) acc[0] += rb_czmq_load_double(ptr);
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+/*
+ *  call-seq:
+ *     frame.sum(type = :double)    =>  Float or Integer
+ *
+ *  Sums the frame data read as little endian 64 bit :double or :int64 elements, without materializing them as Ruby
+ *  objects. Integer sums that overflow 64 bits are promoted to Bignums. Raises ArgumentError if the frame size is
+ *  not a multiple of 8.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_doubles([1.5, 2.0]).sum    =>  3.5
+ *     ZMQ::Frame.from_int64s([1, -2]).sum(:int64)    =>  -1
+ *
+*/
+
+static VALUE rb_czmq_frame_sum(int argc, VALUE *argv, VALUE obj)
+{
+    VALUE type, total = Qnil;
+    long i, count;
+    int64_t sum = 0, value;
+    const unsigned char *ptr = NULL;
+    int kind;
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    rb_scan_args(argc, argv, "01", &type);
+    kind = rb_czmq_frame_numeric_kind(type);
+    count = rb_czmq_frame_numeric_count(frame);
+    ptr = zframe_data(frame->frame);
+    if (kind == ZMQ_NUM_FLOAT) return rb_float_new(rb_czmq_sum_doubles(ptr, count));
+    for (i = 0; i < count; i++, ptr += 8) {
+        value = (int64_t)ZmqLoad64(ptr);
+        if ((value > 0 && sum > INT64_MAX - value) || (value < 0 && sum < INT64_MIN - value)) {
+            /* about to overflow - carry the partial sum over to Ruby Integers */
+            total = NIL_P(total) ? LL2NUM(sum) : rb_funcall(total, rb_intern("+"), 1, LL2NUM(sum));
+            sum = 0;
+        }
+        sum += value;
+    }
+    if (NIL_P(total)) return LL2NUM(sum);
+    return rb_funcall(total, rb_intern("+"), 1, LL2NUM(sum));
+}
+
+/*
+ *  call-seq:
+ *     frame.minmax(type = :double)    =>  Array
+ *
+ *  Returns the minimum and maximum of the frame data read as little endian 64 bit :double or :int64 elements, or
+ *  [nil, nil] for an empty frame. NaNs are ignored. Raises ArgumentError if the frame size is not a multiple of 8.
+ *
+ * === Examples
+ *     ZMQ::Frame.from_doubles([1.5, -2.0, 4.0]).minmax    =>  [-2.0, 4.0]
+ *
+*/
+
+static VALUE rb_czmq_frame_minmax(int argc, VALUE *argv, VALUE obj)
+{
+    VALUE type;
+    long i, count;
+    const unsigned char *ptr = NULL;
+    int kind;
+    bool found = false;
+    ZmqGetFrame(obj);
+    ZmqAssertFrameOwned(frame);
+    rb_scan_args(argc, argv, "01", &type);
+    kind = rb_czmq_frame_numeric_kind(type);
+    count = rb_czmq_frame_numeric_count(frame);
+    ptr = zframe_data(frame->frame);
+    if (kind == ZMQ_NUM_FLOAT) {
+        double value, min = 0.0, max = 0.0;
+        for (i = 0; i < count; i++, ptr += 8) {
+            value = rb_czmq_load_double(ptr);
+            if (value != value) continue;
+            if (!found) {
+                min = max = value;
+                found = true;
+            }
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+        }
+        if (!found) return rb_ary_new3(2, Qnil, Qnil);
+        return rb_ary_new3(2, rb_float_new(min), rb_float_new(max));
+    } else {
+        int64_t value, min = INT64_MAX, max = INT64_MIN;
+        if (count == 0) return rb_ary_new3(2, Qnil, Qnil);
+        for (i = 0; i < count; i++, ptr += 8) {
+            value = (int64_t)ZmqLoad64(ptr);
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+        }
+        return rb_ary_new3(2, LL2NUM(min), LL2NUM(max));
+    }
+}
+
+void _init_rb_czmq_frame_numeric()
+{
+    sym_double = ID2SYM(rb_intern("double"));
+    sym_int64 = ID2SYM(rb_intern("int64"));
+
+    rb_define_singleton_method(rb_cZmqFrame, "from_doubles", rb_czmq_frame_s_from_doubles, 1);
+    rb_define_singleton_method(rb_cZmqFrame, "from_int64s", rb_czmq_frame_s_from_int64s, 1);
+    rb_define_method(rb_cZmqFrame, "to_doubles", rb_czmq_frame_to_doubles, 0);
+    rb_define_method(rb_cZmqFrame, "to_int64s", rb_czmq_frame_to_int64s, 0);
+    rb_define_method(rb_cZmqFrame, "sum", rb_czmq_frame_sum, -1);
+    rb_define_method(rb_cZmqFrame, "minmax", rb_czmq_frame_minmax, -1);
+}
@@ -0,0 +1,280 @@
+#include "rbczmq_ext.h"
+
+/*
+ * :nodoc:
+ *  GC free callback
+ *
+*/
+static void rb_czmq_free_histogram_gc(void *ptr)
+{
+    zmq_histogram *histogram = (zmq_histogram *)ptr;
+    if (histogram) xfree(histogram);
+}
+
+/*
+ * :nodoc:
+ *  Coerces a native histogram to a ZMQ::Histogram instance, copying it. A NULL histogram yields an empty one.
+ *
+*/
+VALUE rb_czmq_histogram_snapshot(zmq_histogram *histogram)
+{
+    zmq_histogram *copy = NULL;
+    VALUE histogram_obj = Data_Make_Struct(rb_cZmqHistogram, zmq_histogram, 0, rb_czmq_free_histogram_gc, copy);
+    if (histogram) MEMCPY(copy, histogram, zmq_histogram, 1);
+    return histogram_obj;
+}
+
+/*
+ * :nodoc:
+ *  Returns the highest value counted in a given bucket.
+ *
+*/
+static uint64_t rb_czmq_histogram_bucket_max(int bucket)
+{
+    int shift;
+    uint64_t sub;
+    if (bucket < ZMQ_HISTOGRAM_SUB_BUCKETS) return (uint64_t)bucket;
+    shift = bucket / ZMQ_HISTOGRAM_SUB_BUCKETS - 1;
+    sub = (uint64_t)(bucket % ZMQ_HISTOGRAM_SUB_BUCKETS + ZMQ_HISTOGRAM_SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Histogram.new    =>  ZMQ::Histogram
+ *
+ *  Creates an empty latency histogram. Socket latency histograms are returned by ZMQ::Socket#send_latency and
+ *  ZMQ::Socket#recv_latency, while empty ones are useful to merge those into.
+ *
+ * === Examples
+ *     ZMQ::Histogram.new    =>  ZMQ::Histogram
+ *
+*/
+
+static VALUE rb_czmq_histogram_s_new(ZMQ_UNUSED VALUE klass)
+{
+    VALUE histogram_obj = rb_czmq_histogram_snapshot(NULL);
+    rb_obj_call_init(histogram_obj, 0, NULL);
+    return histogram_obj;
+}
+
+/*
+ *  call-seq:
+ *     histogram.record(ns)    =>  nil
+ *
+ *  Records a value in nanoseconds.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.record(1500)    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_histogram_record_value(VALUE obj, VALUE value)
+{
+    ZmqGetHistogram(obj);
+    if (NUM2LL(value) < 0) rb_raise(rb_eArgError, "histogram values must not be negative!");
+    rb_czmq_histogram_record(histogram, NUM2ULL(value));
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     histogram.count    =>  Fixnum
+ *
+ *  Returns the number of recorded values.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.count    =>  0
+ *
+*/
+
+static VALUE rb_czmq_histogram_count(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    return ULL2NUM(histogram->count);
+}
+
+/*
+ *  call-seq:
+ *     histogram.min    =>  Fixnum or nil
+ *
+ *  Returns the lowest recorded value in nanoseconds, or nil if the histogram is empty.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.record(1500)
+ *     histogram.min    =>  1500
+ *
+*/
+
+static VALUE rb_czmq_histogram_min(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    if (histogram->count == 0) return Qnil;
+    return ULL2NUM(histogram->min);
+}
+
+/*
+ *  call-seq:
+ *     histogram.max    =>  Fixnum or nil
+ *
+ *  Returns the highest recorded value in nanoseconds, or nil if the histogram is empty.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.record(1500)
+ *     histogram.max    =>  1500
+ *
+*/
+
+static VALUE rb_czmq_histogram_max(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    if (histogram->count == 0) return Qnil;
+    return ULL2NUM(histogram->max);
+}
+
+/*
+ *  call-seq:
+ *     histogram.mean    =>  Float or nil
+ *
+ *  Returns the exact mean of all recorded values in nanoseconds, or nil if the histogram is empty.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.record(1000)
+ *     histogram.record(2000)
+ *     histogram.mean    =>  1500.0
+ *
+*/
+
+static VALUE rb_czmq_histogram_mean(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    if (histogram->count == 0) return Qnil;
+    return rb_float_new((double)histogram->total / (double)histogram->count);
+}
+
+/*
+ *  call-seq:
+ *     histogram.percentile(99.9)    =>  Fixnum or nil
+ *
+ *  Returns the value in nanoseconds below or at which the given percentage of recorded values fall, or nil if the
+ *  histogram is empty. Values are reported as the upper bound of their bucket, capped at the recorded maximum, and
+ *  are thus accurate to within 1/16th.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.record(1000)
+ *     histogram.record(2000)
+ *     histogram.percentile(50)     =>  1023
+ *     histogram.percentile(100)    =>  2000
+ *
+*/
+
+static VALUE rb_czmq_histogram_percentile(VALUE obj, VALUE percentile)
+{
+    double pct;
+    uint64_t target, seen = 0, value;
+    int bucket;
+    ZmqGetHistogram(obj);
+    pct = NUM2DBL(percentile);
+    if (pct < 0.0 || pct > 100.0) rb_raise(rb_eArgError, "percentile must be between 0 and 100!");
+    if (histogram->count == 0) return Qnil;
+    if (pct == 0.0) return ULL2NUM(histogram->min);
+    target = (uint64_t)((pct / 100.0) * (double)histogram->count + 0.5);
+    if (target == 0) target = 1;
+    if (target > histogram->count) target = histogram->count;
+    for (bucket = 0; bucket < ZMQ_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= target) break;
+    }
+    value = rb_czmq_histogram_bucket_max(bucket);
+    if (value > histogram->max) value = histogram->max;
+    if (value < histogram->min) value = histogram->min;
+    return ULL2NUM(value);
+}
+
+/*
+ *  call-seq:
+ *     histogram.merge!(other)    =>  ZMQ::Histogram
+ *
+ *  Adds all values recorded in another histogram to this one.
+ *
+ * === Examples
+ *     total = ZMQ::Histogram.new
+ *     total.merge!(sock.recv_latency)    =>  ZMQ::Histogram
+ *
+*/
+
+static VALUE rb_czmq_histogram_merge_bang(VALUE obj, VALUE other_obj)
+{
+    zmq_histogram *other = NULL;
+    int bucket;
+    ZmqGetHistogram(obj);
+    ZmqAssertHistogram(other_obj);
+    Data_Get_Struct(other_obj, zmq_histogram, other);
+    if (other->count == 0) return obj;
+    if (histogram->count == 0 || other->min < histogram->min) histogram->min = other->min;
+    if (other->max > histogram->max) histogram->max = other->max;
+    histogram->count += other->count;
+    histogram->total += other->total;
+    for (bucket = 0; bucket < ZMQ_HISTOGRAM_BUCKETS; bucket++)
+        histogram->buckets[bucket] += other->buckets[bucket];
+    return obj;
+}
+
+/*
+ *  call-seq:
+ *     histogram.dup    =>  ZMQ::Histogram
+ *
+ *  Returns a copy of this histogram.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.dup    =>  ZMQ::Histogram
+ *
+*/
+
+static VALUE rb_czmq_histogram_dup(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    return rb_czmq_histogram_snapshot(histogram);
+}
+
+/*
+ *  call-seq:
+ *     histogram.reset    =>  nil
+ *
+ *  Discards all recorded values.
+ *
+ * === Examples
+ *     histogram = ZMQ::Histogram.new
+ *     histogram.reset    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_histogram_reset(VALUE obj)
+{
+    ZmqGetHistogram(obj);
+    MEMZERO(histogram, zmq_histogram, 1);
+    return Qnil;
+}
+
+void _init_rb_czmq_histogram()
+{
+    rb_cZmqHistogram = rb_define_class_under(rb_mZmq, "Histogram", rb_cObject);
+
+    rb_define_singleton_method(rb_cZmqHistogram, "new", rb_czmq_histogram_s_new, 0);
+    rb_define_method(rb_cZmqHistogram, "record", rb_czmq_histogram_record_value, 1);
+    rb_define_method(rb_cZmqHistogram, "count", rb_czmq_histogram_count, 0);
+    rb_define_method(rb_cZmqHistogram, "min", rb_czmq_histogram_min, 0);
+    rb_define_method(rb_cZmqHistogram, "max", rb_czmq_histogram_max, 0);
+    rb_define_method(rb_cZmqHistogram, "mean", rb_czmq_histogram_mean, 0);
+    rb_define_method(rb_cZmqHistogram, "percentile", rb_czmq_histogram_percentile, 1);
+    rb_define_method(rb_cZmqHistogram, "merge!", rb_czmq_histogram_merge_bang, 1);
+    rb_define_method(rb_cZmqHistogram, "dup", rb_czmq_histogram_dup, 0);
+    rb_define_method(rb_cZmqHistogram, "reset", rb_czmq_histogram_reset, 0);
+}
@@ -0,0 +1,54 @@
+#ifndef RBCZMQ_HISTOGRAM_H
+#define RBCZMQ_HISTOGRAM_H
+
+/* Log-linear histogram of nanosecond latencies : values below 16 are counted exactly, larger ones in 16 linear
+   sub-buckets per power of 2, which bounds the relative error to 1/16. Values of 2^44 ns (about 4.9 hours) and
+   beyond all land in the last bucket. */
+#define ZMQ_HISTOGRAM_SUB_BITS 4
+#define ZMQ_HISTOGRAM_SUB_BUCKETS (1 << ZMQ_HISTOGRAM_SUB_BITS)
+#define ZMQ_HISTOGRAM_MAX_BITS 44
+#define ZMQ_HISTOGRAM_BUCKETS ((ZMQ_HISTOGRAM_MAX_BITS - ZMQ_HISTOGRAM_SUB_BITS + 1) * ZMQ_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t total;
+    uint32_t buckets[ZMQ_HISTOGRAM_BUCKETS];
+} zmq_histogram;
+
+#define ZmqAssertHistogram(obj) ZmqAssertType(obj, rb_cZmqHistogram, "ZMQ::Histogram")
+#define ZmqGetHistogram(obj) \
+    zmq_histogram *histogram = NULL; \
+    ZmqAssertHistogram(obj); \
+    Data_Get_Struct(obj, zmq_histogram, histogram); \
+    if (!histogram) rb_raise(rb_eTypeError, "uninitialized ZMQ histogram!");
+
+static inline int rb_czmq_histogram_bucket(uint64_t value)
+{
+    int msb = 0;
+    if (value < ZMQ_HISTOGRAM_SUB_BUCKETS) return (int)value;
+    if (value >> ZMQ_HISTOGRAM_MAX_BITS) return ZMQ_HISTOGRAM_BUCKETS - 1;
+#ifdef __GNUC__
+    msb = 63 - __builtin_clzll(value);
+#else
+    while (value >> (msb + 1)) msb++;
+#endif
+    return (msb - ZMQ_HISTOGRAM_SUB_BITS + 1) * ZMQ_HISTOGRAM_SUB_BUCKETS +
+           (int)(value >> (msb - ZMQ_HISTOGRAM_SUB_BITS)) - ZMQ_HISTOGRAM_SUB_BUCKETS;
+}
+
+static inline void rb_czmq_histogram_record(zmq_histogram *histogram, uint64_t value)
+{
+    if (histogram->count == 0 || value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+    histogram->count++;
+    histogram->total += value;
+    histogram->buckets[rb_czmq_histogram_bucket(value)]++;
+}
+
+VALUE rb_czmq_histogram_snapshot(zmq_histogram *histogram);
+
+void _init_rb_czmq_histogram();
+
+#endif
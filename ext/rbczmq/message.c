@@ -16,8 +16,14 @@ void rb_czmq_free_message(zmq_message_wrapper *message)
     message->message = NULL;
 
     if (message->frames) {
-        zlist_destroy(&message->frames);
+        xfree(message->zframes);
+        xfree(message->frames);
+        message->zframes = NULL;
+        message->frames = NULL;
     }
+    message->frames_size = 0;
+    message->frames_capa = 0;
+    message->cursor = -1;
 }
 
 /*
@@ -40,18 +46,13 @@ static void rb_czmq_free_message_gc(void *ptr)
 */
 void rb_czmq_mark_message(zmq_message_wrapper *message)
 {
-    if (message->frames) {
-        VALUE frame = (VALUE)zlist_first(message->frames);
-        while (frame) {
-            rb_gc_mark(frame);
-            frame = (VALUE)zlist_next(message->frames);
-        }
-    }
+    if (message->frames) rb_gc_mark_locations(message->frames, message->frames + message->frames_size);
 }
 
 /*
  * :nodoc:
- *  Coerce a zmsg instance to a native Ruby object.
+ *  Coerce a zmsg instance to a native Ruby object. ZMQ::Frame objects for the message's frames are only created once
+ *  they're accessed, see rb_czmq_message_frame.
  *
 */
 VALUE rb_czmq_alloc_message(zmsg_t *message)
@@ -63,23 +64,141 @@ VALUE rb_czmq_alloc_message(zmsg_t *message)
     m->message = message;
     ZmqAssertObjOnAlloc(m->message, m);
     m->flags = ZMQ_MESSAGE_OWNED;
-    m->frames = zlist_new();
+    m->zframes = NULL;
+    m->frames = NULL;
+    m->frames_size = 0;
+    m->frames_capa = 0;
+    m->cursor = -1;
+
+    rb_obj_call_init(message_obj, 0, NULL);
+    return message_obj;
+}
+
+/*
+ * :nodoc:
+ *  Coerce a frame of this message to a ZMQ::Frame object linked to the message.
+ *
+*/
+static VALUE rb_czmq_message_alloc_frame(zmq_message_wrapper *message, zframe_t *zframe)
+{
+    VALUE frame_object = rb_czmq_alloc_frame(zframe);
+    ZmqGetFrame(frame_object);
+    frame->flags &= ~ZMQ_FRAME_OWNED;
+    frame->message = message;
+    return frame_object;
+}
 
-    /* create ZMQ::Frame objects for all frames in the message and
-       link the ruby objects to this message. */
-    zframe_t* zframe = zmsg_first(message);
+/*
+ * :nodoc:
+ *  Builds the frame table of this message on first access. Messages that are only sent, encoded or consumed with
+ *  popstr never need one.
+ *
+*/
+static void rb_czmq_message_index(zmq_message_wrapper *message)
+{
+    zframe_t *zframe = NULL;
+    size_t index = 0;
+    if (message->frames) return;
+    message->frames_capa = zmsg_size(message->message);
+    if (message->frames_capa < ZMQ_MESSAGE_FRAMES_MIN_CAPA) message->frames_capa = ZMQ_MESSAGE_FRAMES_MIN_CAPA;
+    message->zframes = ALLOC_N(zframe_t *, message->frames_capa);
+    message->frames = ALLOC_N(VALUE, message->frames_capa);
+    zframe = zmsg_first(message->message);
     while (zframe) {
-        VALUE frame_object = rb_czmq_alloc_frame(zframe);
-        ZmqGetFrame(frame_object);
-        frame->flags &= ~ZMQ_FRAME_OWNED;
-        frame->message = m;
-        zlist_append(m->frames, (void*)frame_object);
-        
-        zframe = zmsg_next(message);
+        message->zframes[index] = zframe;
+        message->frames[index] = 0;
+        index++;
+        zframe = zmsg_next(message->message);
     }
+    message->frames_size = index;
+}
 
-    rb_obj_call_init(message_obj, 0, NULL);
-    return message_obj;
+/*
+ * :nodoc:
+ *  Inserts a frame and its ZMQ::Frame object, if any, into the frame table at a given position.
+ *
+*/
+static void rb_czmq_message_insert(zmq_message_wrapper *message, size_t index, zframe_t *zframe, VALUE frame_obj)
+{
+    if (message->frames_size == message->frames_capa) {
+        message->frames_capa *= 2;
+        REALLOC_N(message->zframes, zframe_t *, message->frames_capa);
+        REALLOC_N(message->frames, VALUE, message->frames_capa);
+    }
+    if (index < message->frames_size) {
+        MEMMOVE(message->zframes + index + 1, message->zframes + index, zframe_t *, message->frames_size - index);
+        MEMMOVE(message->frames + index + 1, message->frames + index, VALUE, message->frames_size - index);
+    }
+    message->zframes[index] = zframe;
+    message->frames[index] = frame_obj;
+    message->frames_size++;
+    if (message->cursor >= (long)index) message->cursor++;
+}
+
+/*
+ * :nodoc:
+ *  Removes a frame from the frame table and returns its ZMQ::Frame object, or 0 if none has been created yet.
+ *
+*/
+static VALUE rb_czmq_message_delete(zmq_message_wrapper *message, size_t index)
+{
+    VALUE frame_obj = message->frames[index];
+    message->frames_size--;
+    if (index < message->frames_size) {
+        MEMMOVE(message->zframes + index, message->zframes + index + 1, zframe_t *, message->frames_size - index);
+        MEMMOVE(message->frames + index, message->frames + index + 1, VALUE, message->frames_size - index);
+    }
+    if (message->cursor >= (long)index) message->cursor--;
+    return frame_obj;
+}
+
+/*
+ * :nodoc:
+ *  Returns the ZMQ::Frame object at a given position of the frame table, creating and linking it on first access.
+ *
+*/
+static VALUE rb_czmq_message_frame(zmq_message_wrapper *message, size_t index)
+{
+    if (!message->frames[index])
+        message->frames[index] = rb_czmq_message_alloc_frame(message, message->zframes[index]);
+    return message->frames[index];
+}
+
+/*
+ * :nodoc:
+ *  Hands a frame popped off the message over to its ZMQ::Frame object, if any, or a new one.
+ *
+*/
+static VALUE rb_czmq_message_detach_frame(zmq_message_wrapper *message, zframe_t *zframe, VALUE frame_obj)
+{
+    if (!frame_obj) frame_obj = rb_czmq_message_alloc_frame(message, zframe);
+    {
+        ZmqGetFrame(frame_obj);
+        frame->flags |= ZMQ_FRAME_OWNED;
+        frame->message = NULL;
+    }
+    return frame_obj;
+}
+
+/*
+ * :nodoc:
+ *  Replaces a frame of this message with another one, in place. The replaced frame is not destroyed.
+ *
+*/
+void rb_czmq_message_replace_frame(zmq_message_wrapper *message, zframe_t *zframe, zframe_t *replacement)
+{
+    size_t index, size = zmsg_size(message->message);
+    zframe_t *current = NULL;
+    /* czmq has no positional insert - rotate all frames through the message instead */
+    for (index = 0; index < size; index++) {
+        current = zmsg_pop(message->message);
+        zmsg_add(message->message, current == zframe ? replacement : current);
+    }
+    if (message->frames) {
+        for (index = 0; index < message->frames_size; index++) {
+            if (message->zframes[index] == zframe) message->zframes[index] = replacement;
+        }
+    }
 }
 
 /*
@@ -167,11 +286,12 @@ static VALUE rb_czmq_message_push(VALUE obj, VALUE frame_obj)
     ZmqGetFrame(frame_obj);
     ZmqAssertFrameOwnedNoMessage(frame);
 
+    rb_czmq_message_index(message);
     rc = zmsg_push(message->message, frame->frame);
     ZmqAssert(rc);
     frame->message = message;
     frame->flags &= ~ZMQ_FRAME_OWNED;
-    zlist_push(message->frames, (void*)frame_obj);
+    rb_czmq_message_insert(message, 0, frame->frame, frame_obj);
     return Qtrue;
 }
 
@@ -198,11 +318,12 @@ static VALUE rb_czmq_message_add(VALUE obj, VALUE frame_obj)
     ZmqGetFrame(frame_obj);
     ZmqAssertFrameOwnedNoMessage(frame);
 
+    rb_czmq_message_index(message);
     rc = zmsg_add(message->message, frame->frame);
     ZmqAssert(rc);
     frame->message = message;
     frame->flags &= ~ZMQ_FRAME_OWNED;
-    zlist_append(message->frames, (void*)frame_obj);
+    rb_czmq_message_insert(message, message->frames_size, frame->frame, frame_obj);
     return Qtrue;
 }
 
@@ -228,12 +349,8 @@ static VALUE rb_czmq_message_pop(VALUE obj)
     ZmqAssertMessageOwned(message);
     zframe = zmsg_pop(message->message); /* we now own the frame */
     if (zframe == NULL) return Qnil;
-    VALUE frame_obj = (VALUE)zlist_pop(message->frames);
     /* detach frame from message, it is now owned by the ruby object */
-    ZmqGetFrame(frame_obj);
-    frame->flags |= ZMQ_FRAME_OWNED;
-    frame->message = NULL;
-    return frame_obj ? frame_obj : Qnil;
+    return rb_czmq_message_detach_frame(message, zframe, message->frames ? rb_czmq_message_delete(message, 0) : 0);
 }
 
 /*
@@ -275,8 +392,10 @@ static VALUE rb_czmq_message_first(VALUE obj)
 {
     ZmqGetMessage(obj);
     ZmqReturnNilUnlessOwned(message);
-    VALUE frame_obj = (VALUE)zlist_first(message->frames);
-    return frame_obj ? frame_obj : Qnil;
+    rb_czmq_message_index(message);
+    if (message->frames_size == 0) return Qnil;
+    message->cursor = 0;
+    return rb_czmq_message_frame(message, 0);
 }
 
 /*
@@ -298,8 +417,12 @@ static VALUE rb_czmq_message_next(VALUE obj)
 {
     ZmqGetMessage(obj);
     ZmqReturnNilUnlessOwned(message);
-    VALUE frame_obj = (VALUE)zlist_next(message->frames);
-    return frame_obj ? frame_obj : Qnil;
+    rb_czmq_message_index(message);
+    if (++message->cursor >= (long)message->frames_size) {
+        message->cursor = -1;
+        return Qnil;
+    }
+    return rb_czmq_message_frame(message, message->cursor);
 }
 
 /*
@@ -320,8 +443,10 @@ static VALUE rb_czmq_message_last(VALUE obj)
 {
     ZmqGetMessage(obj);
     ZmqReturnNilUnlessOwned(message);
-    VALUE frame_obj = (VALUE)zlist_last(message->frames);
-    return frame_obj ? frame_obj : Qnil;
+    rb_czmq_message_index(message);
+    if (message->frames_size == 0) return Qnil;
+    message->cursor = message->frames_size - 1;
+    return rb_czmq_message_frame(message, message->cursor);
 }
 
 /*
@@ -345,10 +470,18 @@ static VALUE rb_czmq_message_remove(VALUE obj, VALUE frame_obj)
     ZmqGetMessage(obj);
     ZmqAssertMessageOwned(message);
     ZmqGetFrame(frame_obj);
+    size_t index;
 
-    /* remove from message and our list of frame objects */
+    /* remove from message and our table of frame objects */
     zmsg_remove(message->message, frame->frame);
-    zlist_remove(message->frames, (void*)frame_obj);
+    if (message->frames) {
+        for (index = 0; index < message->frames_size; index++) {
+            if (message->zframes[index] == frame->frame) {
+                rb_czmq_message_delete(message, index);
+                break;
+            }
+        }
+    }
 
     /* removing from message does not destroy the frame,
        therefore, we take ownership of the frame at this point */
@@ -380,13 +513,8 @@ static VALUE rb_czmq_message_pushstr(VALUE obj, VALUE str)
     rc = zmsg_pushmem(message->message, RSTRING_PTR(str), RSTRING_LEN(str));
     ZmqAssert(rc);
 
-    /* keep zlist of frame ruby objects in sync with message's frame list */
-    zframe_t* zframe = zmsg_first(message->message);
-    VALUE frame_object = rb_czmq_alloc_frame(zframe);
-    ZmqGetFrame(frame_object);
-    frame->flags &= ~ZMQ_FRAME_OWNED;
-    frame->message = message;
-    zlist_push(message->frames, (void*)frame_object);
+    /* keep the frame table, if any, in sync with message's frame list */
+    if (message->frames) rb_czmq_message_insert(message, 0, zmsg_first(message->message), 0);
 
     return Qtrue;
 }
@@ -413,13 +541,8 @@ static VALUE rb_czmq_message_addstr(VALUE obj, VALUE str)
     rc = zmsg_addmem(message->message, RSTRING_PTR(str), RSTRING_LEN(str));
     ZmqAssert(rc);
 
-    /* keep zlist of frame ruby objects in sync with message's frame list */
-    zframe_t* zframe = zmsg_last(message->message);
-    VALUE frame_object = rb_czmq_alloc_frame(zframe);
-    ZmqGetFrame(frame_object);
-    frame->flags &= ~ZMQ_FRAME_OWNED;
-    frame->message = message;
-    zlist_append(message->frames, (void*)frame_object);
+    /* keep the frame table, if any, in sync with message's frame list */
+    if (message->frames) rb_czmq_message_insert(message, message->frames_size, zmsg_last(message->message), 0);
 
     return Qtrue;
 }
@@ -440,15 +563,26 @@ static VALUE rb_czmq_message_addstr(VALUE obj, VALUE str)
 static VALUE rb_czmq_message_popstr(VALUE obj)
 {
     char *str = NULL;
+    zframe_t *zframe = NULL;
+    VALUE result;
     ZmqGetMessage(obj);
     ZmqAssertMessageOwned(message);
-    str = zmsg_popstr(message->message);
-    if (str == NULL) return Qnil;
-
-    /* destroys the frame, keep frame objects list in sync: */
-    zlist_pop(message->frames);
+    if (message->frames && message->frames_size > 0 && message->frames[0]) {
+        /* the frame is referenced by a ZMQ::Frame object, hand it over to that one instead of destroying it */
+        zframe = zmsg_pop(message->message);
+        rb_czmq_message_detach_frame(message, zframe, rb_czmq_message_delete(message, 0));
+        str = zframe_strdup(zframe);
+    } else {
+        str = zmsg_popstr(message->message);
+        if (str == NULL) return Qnil;
+
+        /* destroys the frame, keep the frame table in sync: */
+        if (message->frames) rb_czmq_message_delete(message, 0);
+    }
 
-    return rb_str_new2(str);
+    result = rb_str_new2(str);
+    free(str);
+    return result;
 }
 
 /*
@@ -470,6 +604,7 @@ static VALUE rb_czmq_message_wrap(VALUE obj, VALUE frame_obj)
     errno = 0;
     ZmqGetMessage(obj);
     ZmqAssertMessageOwned(message);
+    rb_czmq_message_index(message);
 
     {
         ZmqGetFrame(frame_obj);
@@ -479,19 +614,14 @@ static VALUE rb_czmq_message_wrap(VALUE obj, VALUE frame_obj)
         frame->message = message;
     }
 
-    /* keep frame objects list in sync. Two frames have been added. frame_obj from above
-       and a new one for the empty frame. */
+    /* keep the frame table in sync. Two frames have been added. frame_obj from above
+       and the empty frame. */
     {
-        zmsg_first(message->message);
+        zframe_t* zframe = zmsg_first(message->message);
         zframe_t* empty_frame = zmsg_next(message->message);
 
-        VALUE empty_frame_object = rb_czmq_alloc_frame(empty_frame);
-        ZmqGetFrame(empty_frame_object);
-        frame->flags &= ~ZMQ_FRAME_OWNED;
-        frame->message = message;
-
-        zlist_push(message->frames, (void*)empty_frame_object);
-        zlist_push(message->frames, (void*)frame_obj);
+        rb_czmq_message_insert(message, 0, empty_frame, 0);
+        rb_czmq_message_insert(message, 0, zframe, frame_obj);
     }
     return Qnil;
 }
@@ -520,23 +650,22 @@ static VALUE rb_czmq_message_unwrap(VALUE obj)
     /* reimplemented the zmsg_unwrap function for simpler logic: */
     zframe_t *zframe = zmsg_pop(message->message);
     VALUE frame_obj = 0;
-    if (zframe != NULL) {
-        frame_obj = (VALUE)zlist_pop(message->frames);
-    }
+    if (zframe == NULL) return Qnil;
+    frame_obj = rb_czmq_message_detach_frame(message, zframe, message->frames ? rb_czmq_message_delete(message, 0) : 0);
 
     zframe_t *empty = zmsg_first(message->message);
-    if (zframe_size(empty) == 0) {
+    if (empty && zframe_size(empty) == 0) {
         empty = zmsg_pop(message->message);
-        zframe_destroy (&empty);
-        zlist_pop(message->frames);
-    }
-    
-    {
-        ZmqGetFrame(frame_obj);
-        frame->message = NULL;
-        frame->flags |= ZMQ_FRAME_OWNED;
+        if (message->frames && message->frames[0]) {
+            /* referenced by a ZMQ::Frame object, which takes ownership */
+            rb_czmq_message_detach_frame(message, empty, rb_czmq_message_delete(message, 0));
+        } else {
+            if (message->frames) rb_czmq_message_delete(message, 0);
+            zframe_destroy (&empty);
+        }
     }
-    return frame_obj ? frame_obj : Qnil;
+
+    return frame_obj;
 }
 
 /*
@@ -582,11 +711,110 @@ static VALUE rb_czmq_message_destroy(VALUE obj)
     return Qnil;
 }
 
+/*
+ * :nodoc:
+ *  Returns the size of a message in the zmsg_encode format : each frame prefixed by a single length byte, or by 0xFF
+ *  and a 32 bit big endian length for frames of 255 bytes and more. Raises ArgumentError for frames whose length
+ *  doesn't fit in 32 bits.
+ *
+*/
+static size_t rb_czmq_message_encoded_size(zmsg_t *message)
+{
+    size_t size = 0;
+    zframe_t *zframe = zmsg_first(message);
+    while (zframe) {
+        if (zframe_size(zframe) > UINT32_MAX) rb_raise(rb_eArgError, "frame too large to encode (%lu bytes)!", (unsigned long)zframe_size(zframe));
+        size += zframe_size(zframe) + (zframe_size(zframe) < ZMQ_MESSAGE_ENCODE_LONG ? 1 : 5);
+        zframe = zmsg_next(message);
+    }
+    return size;
+}
+
+/*
+ * :nodoc:
+ *  Encodes a message into a buffer of at least rb_czmq_message_encoded_size bytes. Returns the end of the encoded
+ *  data.
+ *
+*/
+static unsigned char *rb_czmq_message_encode_into(zmsg_t *message, unsigned char *ptr)
+{
+    size_t size;
+    zframe_t *zframe = zmsg_first(message);
+    while (zframe) {
+        size = zframe_size(zframe);
+        if (size < ZMQ_MESSAGE_ENCODE_LONG) {
+            *ptr++ = (unsigned char)size;
+        } else {
+            *ptr++ = ZMQ_MESSAGE_ENCODE_LONG;
+            ZmqWriteUint32BE(ptr, size);
+            ptr += 4;
+        }
+        memcpy(ptr, zframe_data(zframe), size);
+        ptr += size;
+        zframe = zmsg_next(message);
+    }
+    return ptr;
+}
+
+/*
+ * :nodoc:
+ *  Decodes a zmsg_encode formatted buffer. Frames of ZMQ_MESSAGE_ENCODE_LONG bytes and more, and of at least
+ *  ZMQ.zero_copy_threshold bytes, reference the buffer instead of copying it if a String to pin is given - a single
+ *  pin, created on first use, is shared by all of them.
+ *  Returns NULL if the buffer is not properly formatted.
+ *
+*/
+static zmsg_t *rb_czmq_message_decode_buffer(const unsigned char *ptr, size_t len, VALUE source, zmq_zero_copy_pin **pin)
+{
+    const unsigned char *end = ptr + len;
+    size_t size;
+    zframe_t *zframe = NULL;
+    zmsg_t *message = zmsg_new();
+    while (ptr < end) {
+        size = *ptr++;
+        if (size == ZMQ_MESSAGE_ENCODE_LONG) {
+            if (end - ptr < 4) goto malformed;
+            size = ZmqReadUint32BE(ptr);
+            ptr += 4;
+        }
+        if ((size_t)(end - ptr) < size) goto malformed;
+        if (!NIL_P(source) && size >= ZMQ_MESSAGE_ENCODE_LONG && (long)size >= rb_czmq_zero_copy_threshold) {
+            if (!*pin) *pin = rb_czmq_zero_copy_pin_str(source);
+            ZmqAtomicIncrement((*pin)->refs);
+            zframe = zframe_new_zero_copy((void *)ptr, size, rb_czmq_zero_copy_free, *pin);
+        } else {
+            zframe = zframe_new(ptr, size);
+        }
+        zmsg_add(message, zframe);
+        ptr += size;
+    }
+    return message;
+
+malformed:
+    zmsg_destroy(&message);
+    return NULL;
+}
+
+/*
+ * :nodoc:
+ *  Returns the String decoded frames may reference, or nil if frames should be copied, as when zero-copy is disabled
+ *  or the buffer is below ZMQ.zero_copy_threshold. Non-frozen buffers are shared copy-on-write through a frozen
+ *  String, so later changes to them don't affect decoded frames.
+ *
+*/
+static VALUE rb_czmq_message_decode_source(VALUE buffer)
+{
+    if (rb_czmq_zero_copy_threshold < 0 || RSTRING_LEN(buffer) <= ZMQ_MESSAGE_ENCODE_LONG) return Qnil;
+    if (RSTRING_LEN(buffer) < rb_czmq_zero_copy_threshold) return Qnil;
+    return OBJ_FROZEN(buffer) ? buffer : rb_str_new_frozen(buffer);
+}
+
 /*
  *  call-seq:
  *     msg.encode    =>  string
  *
- *  Encodes the message to a new buffer.
+ *  Encodes the message to a new buffer, in the same format as zmsg_encode. Frames are written straight into the
+ *  returned String.
  *
  * === Examples
  *     msg = ZMQ::Message.new    =>  ZMQ::Message
@@ -598,13 +826,11 @@ static VALUE rb_czmq_message_destroy(VALUE obj)
 
 static VALUE rb_czmq_message_encode(VALUE obj)
 {
-    byte *buff;
-    size_t buff_size;
+    VALUE result;
     ZmqGetMessage(obj);
     ZmqReturnNilUnlessOwned(message);
-    buff_size = zmsg_encode(message->message, &buff);
-    VALUE result = rb_str_new((char *)buff, buff_size);
-    free(buff);
+    result = rb_str_new(0, rb_czmq_message_encoded_size(message->message));
+    rb_czmq_message_encode_into(message->message, (unsigned char *)RSTRING_PTR(result));
     return result;
 }
 
@@ -612,7 +838,10 @@ static VALUE rb_czmq_message_encode(VALUE obj)
  *  call-seq:
  *     ZMQ::Message.decode("\006header\004body")    =>  ZMQ::Message
  *
- *  Decode a buffer into a new message. Returns nil if the buffer is not properly formatted.
+ *  Decode a buffer into a new message. Returns nil if the buffer is not properly formatted. Frames are copied by
+ *  default. Referencing the buffer instead is opt-in through ZMQ.zero_copy_threshold : once set, frames of 255 bytes
+ *  and more, and of at least that many bytes, reference the buffer. Non-frozen buffers are then shared copy-on-write
+ *  and can safely be reused.
  *
  * === Examples
  *     msg = ZMQ::Message.decode("\006header\004body")
@@ -624,17 +853,103 @@ static VALUE rb_czmq_message_encode(VALUE obj)
 static VALUE rb_czmq_message_s_decode(ZMQ_UNUSED VALUE obj, VALUE buffer)
 {
     zmsg_t * m = NULL;
+    zmq_zero_copy_pin *pin = NULL;
+    VALUE source;
     Check_Type(buffer, T_STRING);
-    m = zmsg_decode((byte *)RSTRING_PTR(buffer), RSTRING_LEN(buffer));
+    source = rb_czmq_message_decode_source(buffer);
+    if (!NIL_P(source)) buffer = source;
+    m = rb_czmq_message_decode_buffer((const unsigned char *)RSTRING_PTR(buffer), RSTRING_LEN(buffer), source, &pin);
+    rb_czmq_zero_copy_unpin(pin);
     if (m == NULL) return Qnil;
     return rb_czmq_alloc_message(m);
 }
 
+/*
+ *  call-seq:
+ *     ZMQ::Message.encode_many(messages)    =>  String
+ *
+ *  Encodes an Array of messages into a single buffer : each encoded message (see ZMQ::Message#encode) is prefixed
+ *  with its length as a 32 bit big endian integer. Decode with ZMQ::Message.decode_many.
+ *
+ * === Examples
+ *     ZMQ::Message.encode_many([ZMQ::Message("a"), ZMQ::Message("b", "c")])    =>  "\0\0\0\002\001a\0\0\0\004\001b\001c"
+ *
+*/
+
+static VALUE rb_czmq_message_s_encode_many(ZMQ_UNUSED VALUE obj, VALUE messages)
+{
+    VALUE result;
+    long i;
+    size_t total = 0, size;
+    unsigned char *ptr = NULL, *end = NULL;
+    Check_Type(messages, T_ARRAY);
+    for (i = 0; i < RARRAY_LEN(messages); i++) {
+        ZmqGetMessage(RARRAY_PTR(messages)[i]);
+        ZmqAssertMessageOwned(message);
+        size = rb_czmq_message_encoded_size(message->message);
+        if (size > UINT32_MAX) rb_raise(rb_eArgError, "message too large to encode (%lu bytes)!", (unsigned long)size);
+        total += 4 + size;
+    }
+    result = rb_str_new(0, total);
+    ptr = (unsigned char *)RSTRING_PTR(result);
+    for (i = 0; i < RARRAY_LEN(messages); i++) {
+        ZmqGetMessage(RARRAY_PTR(messages)[i]);
+        ZmqAssertMessageOwned(message);
+        end = rb_czmq_message_encode_into(message->message, ptr + 4);
+        ZmqWriteUint32BE(ptr, (size_t)(end - ptr - 4));
+        ptr = end;
+    }
+    return result;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Message.decode_many(buffer)    =>  Array or nil
+ *
+ *  Decodes a buffer produced by ZMQ::Message.encode_many into an Array of messages. Returns nil if the buffer is not
+ *  properly formatted. Large frames reference the buffer if ZMQ.zero_copy_threshold is set, as with
+ *  ZMQ::Message.decode.
+ *
+ * === Examples
+ *     buffer = ZMQ::Message.encode_many([ZMQ::Message("a"), ZMQ::Message("b", "c")])
+ *     ZMQ::Message.decode_many(buffer)    =>  [ZMQ::Message, ZMQ::Message]
+ *
+*/
+
+static VALUE rb_czmq_message_s_decode_many(ZMQ_UNUSED VALUE obj, VALUE buffer)
+{
+    VALUE messages, source;
+    const unsigned char *ptr = NULL, *end = NULL;
+    size_t size;
+    zmsg_t *m = NULL;
+    zmq_zero_copy_pin *pin = NULL;
+    Check_Type(buffer, T_STRING);
+    source = rb_czmq_message_decode_source(buffer);
+    if (!NIL_P(source)) buffer = source;
+    messages = rb_ary_new();
+    ptr = (const unsigned char *)RSTRING_PTR(buffer);
+    end = ptr + RSTRING_LEN(buffer);
+    while (ptr < end) {
+        if (end - ptr < 4) break;
+        size = ZmqReadUint32BE(ptr);
+        ptr += 4;
+        if ((size_t)(end - ptr) < size) break;
+        m = rb_czmq_message_decode_buffer(ptr, size, source, &pin);
+        if (m == NULL) break;
+        rb_ary_push(messages, rb_czmq_alloc_message(m));
+        ptr += size;
+    }
+    rb_czmq_zero_copy_unpin(pin);
+    /* messages decoded so far are reclaimed by the GC */
+    if (ptr < end) return Qnil;
+    return messages;
+}
+
 /*
  *  call-seq:
  *     msg.eql?(other)    =>  boolean
  *
- *  Determines if a message equals another. True if size, content size and serialized representation is equal.
+ *  Determines if a message equals another. True if both have the same number of frames with identical sizes and data.
  *
  * === Examples
  *     msg = ZMQ::Message("header", "body")
@@ -646,24 +961,34 @@ static VALUE rb_czmq_message_s_decode(ZMQ_UNUSED VALUE obj, VALUE buffer)
 static VALUE rb_czmq_message_eql_p(VALUE obj, VALUE other_message)
 {
     zmq_message_wrapper *other = NULL;
-    byte *buff = NULL;
-    size_t buff_size;
-    byte *other_buff = NULL;
-    size_t other_buff_size;
+    zframe_t *zframe = NULL;
+    zframe_t *other_zframe = NULL;
     ZmqGetMessage(obj);
     ZmqAssertMessage(other_message);
     ZmqAssertMessageOwned(message);
     Data_Get_Struct(other_message, zmq_message_wrapper, other);
     if (!other) rb_raise(rb_eTypeError, "uninitialized ZMQ message!");
     ZmqAssertMessageOwned(other);
+    if (message == other) return Qtrue;
 
     if (zmsg_size(message->message) != zmsg_size(other->message)) return Qfalse;
-    if (zmsg_content_size(message->message) != zmsg_content_size(other->message)) return Qfalse;
 
-    buff_size = zmsg_encode(message->message, &buff);
-    other_buff_size = zmsg_encode(other->message, &other_buff);
-    if (buff_size != other_buff_size) return Qfalse;
-    if (strncmp((const char*)buff, (const char*)other_buff, buff_size) != 0) return Qfalse;
+    /* compare all frame sizes before touching any frame data */
+    zframe = zmsg_first(message->message);
+    other_zframe = zmsg_first(other->message);
+    while (zframe) {
+        if (zframe_size(zframe) != zframe_size(other_zframe)) return Qfalse;
+        zframe = zmsg_next(message->message);
+        other_zframe = zmsg_next(other->message);
+    }
+
+    zframe = zmsg_first(message->message);
+    other_zframe = zmsg_first(other->message);
+    while (zframe) {
+        if (memcmp(zframe_data(zframe), zframe_data(other_zframe), zframe_size(zframe)) != 0) return Qfalse;
+        zframe = zmsg_next(message->message);
+        other_zframe = zmsg_next(other->message);
+    }
     return Qtrue;
 }
 
@@ -671,7 +996,7 @@ static VALUE rb_czmq_message_eql_p(VALUE obj, VALUE other_message)
  *  call-seq:
  *     msg == other    =>  boolean
  *
- *  Determines if a message equals another. True if size, content size and serialized representation is equal.
+ *  Determines if a message equals another. True if both have the same number of frames with identical sizes and data.
  *
  * === Examples
  *     msg = ZMQ::Message("header", "body")
@@ -686,6 +1011,34 @@ static VALUE rb_czmq_message_equals(VALUE obj, VALUE other_message)
     return rb_czmq_message_eql_p(obj, other_message);
 }
 
+/*
+ *  call-seq:
+ *     msg.hash    =>  Fixnum
+ *
+ *  Returns a hash of all frames of this message, consistent with ZMQ::Message#eql? - messages can be used as Hash
+ *  keys.
+ *
+ * === Examples
+ *     msg = ZMQ::Message("header", "body")
+ *     msg.hash == ZMQ::Message("header", "body").hash    =>   true
+ *
+*/
+
+static VALUE rb_czmq_message_hash(VALUE obj)
+{
+    zframe_t *zframe = NULL;
+    uint64_t h;
+    ZmqGetMessage(obj);
+    ZmqAssertMessageOwned(message);
+    h = (uint64_t)zmsg_size(message->message);
+    zframe = zmsg_first(message->message);
+    while (zframe) {
+        h = rb_czmq_hash(zframe_data(zframe), zframe_size(zframe), h);
+        zframe = zmsg_next(message->message);
+    }
+    return ZmqHash2Fix(h);
+}
+
 /*
  *  call-seq:
  *     msg.to_a    =>  Array
@@ -704,15 +1057,68 @@ static VALUE rb_czmq_message_to_a(VALUE obj)
     VALUE ary;
     ZmqGetMessage(obj);
     ZmqAssertMessageOwned(message);
-    ary = rb_ary_new2(zlist_size(message->frames));
-    VALUE frame_obj = (VALUE)zlist_first(message->frames);
-    while (frame_obj) {
-        rb_ary_push(ary, frame_obj);
-        frame_obj = (VALUE)zlist_next(message->frames);
+    size_t index;
+    rb_czmq_message_index(message);
+    ary = rb_ary_new2(message->frames_size);
+    for (index = 0; index < message->frames_size; index++) {
+        rb_ary_push(ary, rb_czmq_message_frame(message, index));
     }
     return ary;
 }
 
+/*
+ *  call-seq:
+ *     msg[index]    =>  ZMQ::Frame or nil
+ *     msg.at(index)    =>  ZMQ::Frame or nil
+ *
+ *  Returns the frame at a given position, or nil if out of range. Negative indexes count backwards from the last
+ *  frame. Does not move the cursor used by ZMQ::Message#first and ZMQ::Message#next.
+ *
+ * === Examples
+ *     msg = ZMQ::Message("header", "body")  =>   ZMQ::Message
+ *     msg[1]                                =>   ZMQ::Frame("body")
+ *     msg.at(-2)                            =>   ZMQ::Frame("header")
+ *     msg[2]                                =>   nil
+ *
+*/
+
+static VALUE rb_czmq_message_at(VALUE obj, VALUE idx)
+{
+    long index;
+    ZmqGetMessage(obj);
+    ZmqReturnNilUnlessOwned(message);
+    index = NUM2LONG(idx);
+    rb_czmq_message_index(message);
+    if (index < 0) index += (long)message->frames_size;
+    if (index < 0 || index >= (long)message->frames_size) return Qnil;
+    return rb_czmq_message_frame(message, (size_t)index);
+}
+
+/*
+ *  call-seq:
+ *     msg.each_frame { |frame| }    =>  ZMQ::Message
+ *
+ *  Yields each frame of this message in order. Returns an Enumerator if no block given.
+ *
+ * === Examples
+ *     msg = ZMQ::Message("header", "body")     =>   ZMQ::Message
+ *     msg.each_frame { |frame| p frame.data }    =>   ZMQ::Message
+ *
+*/
+
+static VALUE rb_czmq_message_each_frame(VALUE obj)
+{
+    size_t index;
+    RETURN_ENUMERATOR(obj, 0, 0);
+    ZmqGetMessage(obj);
+    ZmqAssertMessageOwned(message);
+    rb_czmq_message_index(message);
+    for (index = 0; index < message->frames_size && (message->flags & ZMQ_MESSAGE_OWNED); index++) {
+        rb_yield(rb_czmq_message_frame(message, index));
+    }
+    return obj;
+}
+
 /*
  * call-seq:
  *    msg.gone?   #=> false
@@ -735,6 +1141,8 @@ void _init_rb_czmq_message()
     rb_cZmqMessage = rb_define_class_under(rb_mZmq, "Message", rb_cObject);
 
     rb_define_singleton_method(rb_cZmqMessage, "decode", rb_czmq_message_s_decode, 1);
+    rb_define_singleton_method(rb_cZmqMessage, "encode_many", rb_czmq_message_s_encode_many, 1);
+    rb_define_singleton_method(rb_cZmqMessage, "decode_many", rb_czmq_message_s_decode_many, 1);
 
     rb_define_alloc_func(rb_cZmqMessage, rb_czmq_message_new);
     rb_define_method(rb_cZmqMessage, "size", rb_czmq_message_size, 0);
@@ -757,6 +1165,10 @@ void _init_rb_czmq_message()
     rb_define_method(rb_cZmqMessage, "encode", rb_czmq_message_encode, 0);
     rb_define_method(rb_cZmqMessage, "eql?", rb_czmq_message_equals, 1);
     rb_define_method(rb_cZmqMessage, "==", rb_czmq_message_equals, 1);
+    rb_define_method(rb_cZmqMessage, "hash", rb_czmq_message_hash, 0);
     rb_define_method(rb_cZmqMessage, "to_a", rb_czmq_message_to_a, 0);
+    rb_define_method(rb_cZmqMessage, "[]", rb_czmq_message_at, 1);
+    rb_define_method(rb_cZmqMessage, "at", rb_czmq_message_at, 1);
+    rb_define_method(rb_cZmqMessage, "each_frame", rb_czmq_message_each_frame, 0);
     rb_define_method(rb_cZmqMessage, "gone?", rb_czmq_message_gone, 0);
 }
@@ -5,11 +5,33 @@
    and can be freed when the ZMQ::Message object is garbage collected */
 #define ZMQ_MESSAGE_OWNED 0x01
 
+#define ZMQ_MESSAGE_FRAMES_MIN_CAPA 8
+
+/* Frames of this size and larger are prefixed by this marker and a 32 bit length in the zmsg_encode format */
+#define ZMQ_MESSAGE_ENCODE_LONG 0xFF
+
+#define ZmqWriteUint32BE(ptr, value) \
+  do { \
+      (ptr)[0] = (unsigned char)((value) >> 24); \
+      (ptr)[1] = (unsigned char)((value) >> 16); \
+      (ptr)[2] = (unsigned char)((value) >> 8); \
+      (ptr)[3] = (unsigned char)(value); \
+  } while(0)
+
+#define ZmqReadUint32BE(ptr) \
+    (((size_t)(ptr)[0] << 24) | ((size_t)(ptr)[1] << 16) | ((size_t)(ptr)[2] << 8) | (size_t)(ptr)[3])
+
 typedef struct {
     zmsg_t  *message;
     int flags;
-    /* a zlist of frame wrapper objects for the frames in this message */
-    zlist_t *frames;
+    /* Frame table, NULL until a frame is first accessed : the frames of this message in order and at the same
+       positions their ZMQ::Frame wrapper objects, or 0 for those not created yet. */
+    zframe_t **zframes;
+    VALUE *frames;
+    size_t frames_size;
+    size_t frames_capa;
+    /* position of the frame last returned by first, next or last, -1 if none */
+    long cursor;
 } zmq_message_wrapper;
 
 #define ZmqAssertMessage(obj) ZmqAssertType(obj, rb_cZmqMessage, "ZMQ::Message")
@@ -34,6 +56,7 @@ typedef struct {
 VALUE rb_czmq_alloc_message(zmsg_t *message);
 void rb_czmq_free_message(zmq_message_wrapper *message);
 void rb_czmq_mark_message(zmq_message_wrapper *message);
+void rb_czmq_message_replace_frame(zmq_message_wrapper *message, zframe_t *zframe, zframe_t *replacement);
 
 void _init_rb_czmq_message();
 
@@ -0,0 +1,340 @@
+#include "rbczmq_ext.h"
+
+/* A minimal MessagePack codec for the core types (nil, booleans, Integers, Floats, Strings, Symbols, Arrays and
+   Hashes) that encodes straight into zmq_msg_t buffers and decodes straight from received message or frame data,
+   without intermediate Strings. Binary Strings map to the bin family, all others to str. Extension types are not
+   supported. */
+
+typedef struct {
+    const unsigned char *ptr;
+    const unsigned char *end;
+    int depth;
+} zmq_msgpack_reader;
+
+struct zmq_msgpack_hash_args {
+    zmq_msgpack_buffer *buffer;
+    int depth;
+};
+
+static void rb_czmq_msgpack_pack_value(zmq_msgpack_buffer *buffer, VALUE obj, int depth);
+static VALUE rb_czmq_msgpack_unpack_value(zmq_msgpack_reader *reader);
+
+/*
+ * :nodoc:
+ *  libzmq free callback for encoded message buffers
+ *
+*/
+void rb_czmq_msgpack_free(void *data, ZMQ_UNUSED void *hint)
+{
+    free(data);
+}
+
+/*
+ * :nodoc:
+ *  Reserves room for at least size more bytes and returns a pointer to the end of the buffer.
+ *
+*/
+static unsigned char *rb_czmq_msgpack_reserve(zmq_msgpack_buffer *buffer, size_t size)
+{
+    unsigned char *data = NULL;
+    size_t capa = buffer->capa ? buffer->capa : ZMQ_MSGPACK_INITIAL_CAPA;
+    if (buffer->size + size > buffer->capa) {
+        while (capa < buffer->size + size) capa *= 2;
+        data = realloc(buffer->data, capa);
+        if (data == NULL) rb_memerror();
+        buffer->data = data;
+        buffer->capa = capa;
+    }
+    return buffer->data + buffer->size;
+}
+
+static void rb_czmq_msgpack_write(zmq_msgpack_buffer *buffer, const void *data, size_t size)
+{
+    memcpy(rb_czmq_msgpack_reserve(buffer, size), data, size);
+    buffer->size += size;
+}
+
+/*
+ * :nodoc:
+ *  Writes a type byte followed by a big endian value of the given width.
+ *
+*/
+static void rb_czmq_msgpack_write_header(zmq_msgpack_buffer *buffer, unsigned char type, uint64_t value, int width)
+{
+    unsigned char *ptr = rb_czmq_msgpack_reserve(buffer, 1 + width);
+    ptr[0] = type;
+    rb_czmq_store(ptr + 1, value, width, true);
+    buffer->size += 1 + width;
+}
+
+/*
+ * :nodoc:
+ *  Writes the header of a variable length type, picking the fix variant when a fix_type is given and the length fits.
+ *
+*/
+static void rb_czmq_msgpack_write_length(zmq_msgpack_buffer *buffer, size_t length, int fix_type, size_t fix_max, int type8, unsigned char type16, unsigned char type32)
+{
+    if (fix_type >= 0 && length <= fix_max) {
+        rb_czmq_msgpack_write_header(buffer, (unsigned char)(fix_type | length), 0, 0);
+    } else if (type8 >= 0 && length <= 0xFF) {
+        rb_czmq_msgpack_write_header(buffer, (unsigned char)type8, length, 1);
+    } else if (length <= 0xFFFF) {
+        rb_czmq_msgpack_write_header(buffer, type16, length, 2);
+    } else if (length <= 0xFFFFFFFFUL) {
+        rb_czmq_msgpack_write_header(buffer, type32, length, 4);
+    } else {
+        rb_raise(rb_eArgError, "object too large to pack (%lu)", (unsigned long)length);
+    }
+}
+
+static void rb_czmq_msgpack_pack_int(zmq_msgpack_buffer *buffer, int64_t value)
+{
+    if (value >= 0) {
+        if (value <= 0x7F) {
+            rb_czmq_msgpack_write_header(buffer, (unsigned char)value, 0, 0);
+        } else if (value <= 0xFF) {
+            rb_czmq_msgpack_write_header(buffer, 0xcc, (uint64_t)value, 1);
+        } else if (value <= 0xFFFF) {
+            rb_czmq_msgpack_write_header(buffer, 0xcd, (uint64_t)value, 2);
+        } else if (value <= 0xFFFFFFFFLL) {
+            rb_czmq_msgpack_write_header(buffer, 0xce, (uint64_t)value, 4);
+        } else {
+            rb_czmq_msgpack_write_header(buffer, 0xcf, (uint64_t)value, 8);
+        }
+    } else if (value >= -32) {
+        rb_czmq_msgpack_write_header(buffer, (unsigned char)(int8_t)value, 0, 0);
+    } else if (value >= INT8_MIN) {
+        rb_czmq_msgpack_write_header(buffer, 0xd0, (uint64_t)value, 1);
+    } else if (value >= INT16_MIN) {
+        rb_czmq_msgpack_write_header(buffer, 0xd1, (uint64_t)value, 2);
+    } else if (value >= INT32_MIN) {
+        rb_czmq_msgpack_write_header(buffer, 0xd2, (uint64_t)value, 4);
+    } else {
+        rb_czmq_msgpack_write_header(buffer, 0xd3, (uint64_t)value, 8);
+    }
+}
+
+static void rb_czmq_msgpack_pack_string(zmq_msgpack_buffer *buffer, VALUE str)
+{
+    size_t length = (size_t)RSTRING_LEN(str);
+    if (rb_enc_get_index(str) == rb_ascii8bit_encindex()) {
+        rb_czmq_msgpack_write_length(buffer, length, -1, 0, 0xc4, 0xc5, 0xc6);
+    } else {
+        rb_czmq_msgpack_write_length(buffer, length, 0xa0, 31, 0xd9, 0xda, 0xdb);
+    }
+    rb_czmq_msgpack_write(buffer, RSTRING_PTR(str), length);
+}
+
+static int rb_czmq_msgpack_pack_pair(VALUE key, VALUE value, VALUE ptr)
+{
+    struct zmq_msgpack_hash_args *args = (struct zmq_msgpack_hash_args *)ptr;
+    rb_czmq_msgpack_pack_value(args->buffer, key, args->depth);
+    rb_czmq_msgpack_pack_value(args->buffer, value, args->depth);
+    return ST_CONTINUE;
+}
+
+static void rb_czmq_msgpack_pack_value(zmq_msgpack_buffer *buffer, VALUE obj, int depth)
+{
+    long i;
+    double value;
+    uint64_t bits;
+    struct zmq_msgpack_hash_args args;
+    if (depth > ZMQ_MSGPACK_MAX_DEPTH) rb_raise(rb_eArgError, "nesting of %d is too deep to pack", depth);
+    switch (TYPE(obj)) {
+    case T_NIL:
+        rb_czmq_msgpack_write_header(buffer, 0xc0, 0, 0);
+        break;
+    case T_FALSE:
+        rb_czmq_msgpack_write_header(buffer, 0xc2, 0, 0);
+        break;
+    case T_TRUE:
+        rb_czmq_msgpack_write_header(buffer, 0xc3, 0, 0);
+        break;
+    case T_FIXNUM:
+        rb_czmq_msgpack_pack_int(buffer, (int64_t)FIX2LONG(obj));
+        break;
+    case T_BIGNUM:
+        if (RTEST(rb_funcall(obj, rb_intern("<"), 1, INT2FIX(0)))) {
+            rb_czmq_msgpack_pack_int(buffer, (int64_t)NUM2LL(obj));
+        } else {
+            rb_czmq_msgpack_write_header(buffer, 0xcf, (uint64_t)NUM2ULL(obj), 8);
+        }
+        break;
+    case T_FLOAT:
+        value = NUM2DBL(obj);
+        memcpy(&bits, &value, 8);
+        rb_czmq_msgpack_write_header(buffer, 0xcb, bits, 8);
+        break;
+    case T_STRING:
+        rb_czmq_msgpack_pack_string(buffer, obj);
+        break;
+    case T_SYMBOL:
+        rb_czmq_msgpack_pack_string(buffer, rb_id2str(SYM2ID(obj)));
+        break;
+    case T_ARRAY:
+        rb_czmq_msgpack_write_length(buffer, (size_t)RARRAY_LEN(obj), 0x90, 15, -1, 0xdc, 0xdd);
+        for (i = 0; i < RARRAY_LEN(obj); i++) rb_czmq_msgpack_pack_value(buffer, rb_ary_entry(obj, i), depth + 1);
+        break;
+    case T_HASH:
+        rb_czmq_msgpack_write_length(buffer, (size_t)RHASH_SIZE(obj), 0x80, 15, -1, 0xde, 0xdf);
+        args.buffer = buffer;
+        args.depth = depth + 1;
+        rb_hash_foreach(obj, rb_czmq_msgpack_pack_pair, (VALUE)&args);
+        break;
+    default:
+        rb_raise(rb_eTypeError, "can't pack %s to MessagePack", rb_obj_classname(obj));
+    }
+}
+
+static VALUE rb_czmq_msgpack_pack_protected(VALUE ptr)
+{
+    VALUE *args = (VALUE *)ptr;
+    rb_czmq_msgpack_pack_value((zmq_msgpack_buffer *)args[0], args[1], 0);
+    return Qnil;
+}
+
+/*
+ * :nodoc:
+ *  Appends the MessagePack encoding of obj to the buffer. The buffer is released before re-raising if encoding fails,
+ *  otherwise ownership of its data passes to the caller.
+ *
+*/
+void rb_czmq_msgpack_pack(zmq_msgpack_buffer *buffer, VALUE obj)
+{
+    int state = 0;
+    VALUE args[2];
+    args[0] = (VALUE)buffer;
+    args[1] = obj;
+    rb_protect(rb_czmq_msgpack_pack_protected, (VALUE)args, &state);
+    if (state) {
+        free(buffer->data);
+        buffer->data = NULL;
+        buffer->size = buffer->capa = 0;
+        rb_jump_tag(state);
+    }
+}
+
+#define ZmqMsgpackMalformed() rb_raise(rb_eZmqError, "malformed MessagePack data")
+
+/*
+ * :nodoc:
+ *  Consumes size bytes from the reader, raising if the input is truncated.
+ *
+*/
+static const unsigned char *rb_czmq_msgpack_read(zmq_msgpack_reader *reader, size_t size)
+{
+    const unsigned char *ptr = reader->ptr;
+    if ((size_t)(reader->end - reader->ptr) < size) ZmqMsgpackMalformed();
+    reader->ptr += size;
+    return ptr;
+}
+
+static uint64_t rb_czmq_msgpack_read_uint(zmq_msgpack_reader *reader, int width)
+{
+    return rb_czmq_load(rb_czmq_msgpack_read(reader, width), width, true);
+}
+
+static VALUE rb_czmq_msgpack_unpack_str(zmq_msgpack_reader *reader, size_t length, bool binary)
+{
+    const char *ptr = (const char *)rb_czmq_msgpack_read(reader, length);
+    if (binary) return ZmqEncode(rb_str_new(ptr, length));
+    return rb_enc_str_new(ptr, length, rb_utf8_encoding());
+}
+
+static VALUE rb_czmq_msgpack_unpack_array(zmq_msgpack_reader *reader, size_t count)
+{
+    size_t i;
+    VALUE array;
+    /* every element takes at least a byte, which bounds the allocation by the input size */
+    if ((size_t)(reader->end - reader->ptr) < count) ZmqMsgpackMalformed();
+    if (++reader->depth > ZMQ_MSGPACK_MAX_DEPTH) rb_raise(rb_eArgError, "nesting of %d is too deep to unpack", reader->depth);
+    array = rb_ary_new2((long)count);
+    for (i = 0; i < count; i++) rb_ary_push(array, rb_czmq_msgpack_unpack_value(reader));
+    reader->depth--;
+    return array;
+}
+
+static VALUE rb_czmq_msgpack_unpack_map(zmq_msgpack_reader *reader, size_t count)
+{
+    size_t i;
+    VALUE hash, key;
+    if ((size_t)(reader->end - reader->ptr) / 2 < count) ZmqMsgpackMalformed();
+    if (++reader->depth > ZMQ_MSGPACK_MAX_DEPTH) rb_raise(rb_eArgError, "nesting of %d is too deep to unpack", reader->depth);
+    hash = rb_hash_new();
+    for (i = 0; i < count; i++) {
+        key = rb_czmq_msgpack_unpack_value(reader);
+        rb_hash_aset(hash, key, rb_czmq_msgpack_unpack_value(reader));
+    }
+    reader->depth--;
+    return hash;
+}
+
+static VALUE rb_czmq_msgpack_unpack_value(zmq_msgpack_reader *reader)
+{
+    unsigned char type = *rb_czmq_msgpack_read(reader, 1);
+    uint64_t bits;
+    float f32;
+    double f64;
+    if (type <= 0x7f) return INT2FIX(type);
+    if (type >= 0xe0) return INT2FIX((int8_t)type);
+    if ((type & 0xe0) == 0xa0) return rb_czmq_msgpack_unpack_str(reader, type & 0x1f, false);
+    if ((type & 0xf0) == 0x90) return rb_czmq_msgpack_unpack_array(reader, type & 0x0f);
+    if ((type & 0xf0) == 0x80) return rb_czmq_msgpack_unpack_map(reader, type & 0x0f);
+    switch (type) {
+    case 0xc0: return Qnil;
+    case 0xc2: return Qfalse;
+    case 0xc3: return Qtrue;
+    case 0xc4: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 1), true);
+    case 0xc5: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 2), true);
+    case 0xc6: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 4), true);
+    case 0xca:
+        bits = rb_czmq_msgpack_read_uint(reader, 4);
+        {
+            uint32_t bits32 = (uint32_t)bits;
+            memcpy(&f32, &bits32, 4);
+        }
+        return rb_float_new((double)f32);
+    case 0xcb:
+        bits = rb_czmq_msgpack_read_uint(reader, 8);
+        memcpy(&f64, &bits, 8);
+        return rb_float_new(f64);
+    case 0xcc: return INT2FIX((int)rb_czmq_msgpack_read_uint(reader, 1));
+    case 0xcd: return INT2FIX((int)rb_czmq_msgpack_read_uint(reader, 2));
+    case 0xce: return ULL2NUM(rb_czmq_msgpack_read_uint(reader, 4));
+    case 0xcf: return ULL2NUM(rb_czmq_msgpack_read_uint(reader, 8));
+    case 0xd0: return INT2FIX((int8_t)rb_czmq_msgpack_read_uint(reader, 1));
+    case 0xd1: return INT2FIX((int16_t)rb_czmq_msgpack_read_uint(reader, 2));
+    case 0xd2: return LL2NUM((int32_t)rb_czmq_msgpack_read_uint(reader, 4));
+    case 0xd3: return LL2NUM((int64_t)rb_czmq_msgpack_read_uint(reader, 8));
+    case 0xd9: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 1), false);
+    case 0xda: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 2), false);
+    case 0xdb: return rb_czmq_msgpack_unpack_str(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 4), false);
+    case 0xdc: return rb_czmq_msgpack_unpack_array(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 2));
+    case 0xdd: return rb_czmq_msgpack_unpack_array(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 4));
+    case 0xde: return rb_czmq_msgpack_unpack_map(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 2));
+    case 0xdf: return rb_czmq_msgpack_unpack_map(reader, (size_t)rb_czmq_msgpack_read_uint(reader, 4));
+    case 0xc7: case 0xc8: case 0xc9:
+    case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+        rb_raise(rb_eZmqError, "MessagePack extension types are not supported");
+    default:
+        ZmqMsgpackMalformed();
+    }
+    return Qnil;
+}
+
+/*
+ * :nodoc:
+ *  Decodes a single MessagePack object spanning the given data, raising ZMQ::Error on malformed or trailing input.
+ *
+*/
+VALUE rb_czmq_msgpack_unpack(const unsigned char *data, size_t size)
+{
+    VALUE obj;
+    zmq_msgpack_reader reader;
+    reader.ptr = data;
+    reader.end = data + size;
+    reader.depth = 0;
+    obj = rb_czmq_msgpack_unpack_value(&reader);
+    if (reader.ptr != reader.end) ZmqMsgpackMalformed();
+    return obj;
+}
@@ -0,0 +1,20 @@
+#ifndef RBCZMQ_MSGPACK_H
+#define RBCZMQ_MSGPACK_H
+
+/* Nesting limit for both directions - guards the C stack against deeply nested or hostile input */
+#define ZMQ_MSGPACK_MAX_DEPTH 512
+#define ZMQ_MSGPACK_INITIAL_CAPA 256
+
+/* A growable encode buffer. Data is allocated with plain malloc as it's handed over to a zmq_msg_t and released by
+   rb_czmq_msgpack_free, possibly from a libzmq I/O thread. */
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capa;
+} zmq_msgpack_buffer;
+
+void rb_czmq_msgpack_pack(zmq_msgpack_buffer *buffer, VALUE obj);
+VALUE rb_czmq_msgpack_unpack(const unsigned char *data, size_t size);
+void rb_czmq_msgpack_free(void *data, void *hint);
+
+#endif
@@ -15,6 +15,23 @@ static void rb_czmq_mark_poller(void *ptr)
     }
 }
 
+/*
+ * :nodoc:
+ *  Unlinks a registration from the socket it belongs to, unless the socket's been freed already.
+ *
+*/
+static void rb_czmq_poller_unlink(zmq_poller_entry *entry)
+{
+    if (!entry->linked) return;
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        entry->sock->registrations = entry->next;
+    }
+    if (entry->next) entry->next->prev = entry->prev;
+    entry->linked = false;
+}
+
 /*
  * :nodoc:
  *  GC free callback
@@ -23,53 +40,146 @@ static void rb_czmq_mark_poller(void *ptr)
 static void rb_czmq_free_poller_gc(void *ptr)
 {
     zmq_poll_wrapper *poller = (zmq_poll_wrapper *)ptr;
+    int i;
     if (poller) {
+        if (poller->epoll_fd != -1) close(poller->epoll_fd);
+        if (poller->entries) {
+            for (i = 0; i < poller->poll_size; i++) {
+                rb_czmq_poller_unlink(poller->entries[i]);
+                close(poller->entries[i]->fd);
+                xfree(poller->entries[i]);
+            }
+        }
+        xfree(poller->entries);
         xfree(poller->pollset);
+        xfree(poller->items);
+        st_free_table(poller->index);
+        xfree(poller->ready);
+        xfree(poller->scratch);
+        xfree(poller->pending);
+        xfree(poller->touched);
+#ifdef HAVE_SYS_EPOLL_H
+        xfree(poller->events);
+#endif
         xfree(poller);
     }
 }
 
 /*
  * :nodoc:
- *  Rebuild the pollset from the sockets registered with this poller
+ *  Sizes the pollset, ready list and the epoll backend's registrations, pending list and event buffer for capa
+ *  registered items. The ready and pending lists are filled while the GIL is released, thus sized for all registered
+ *  items upfront.
  *
 */
-int rb_czmq_poller_rebuild_pollset(zmq_poll_wrapper *poller)
+static void rb_czmq_poller_resize(zmq_poll_wrapper *poller, int capa)
 {
-    VALUE pollable;
-    int rebuilt;
-    xfree(poller->pollset);
-    poller->pollset = NULL;
-    poller->pollset = ALLOC_N(zmq_pollitem_t, poller->poll_size);
-    if (!poller->pollset) return -1;
-    for (rebuilt = 0; rebuilt < poller->poll_size; rebuilt++) {
-        pollable = rb_ary_entry(poller->pollables, (long)rebuilt);
-        ZmqGetPollitem(pollable);
-        poller->pollset[rebuilt] = *pollitem->item;
-    }
-    poller->dirty = false;
-    return 0;
+    REALLOC_N(poller->pollset, zmq_pollitem_t, capa);
+    REALLOC_N(poller->items, zmq_pollitem_wrapper *, capa);
+    REALLOC_N(poller->ready, zmq_poll_ready, capa);
+    REALLOC_N(poller->scratch, zmq_poll_ready, capa);
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->backend == ZMQ_POLLER_EPOLL) {
+        REALLOC_N(poller->entries, zmq_poller_entry *, capa);
+        REALLOC_N(poller->pending, zmq_poller_entry *, capa);
+        REALLOC_N(poller->touched, zmq_poller_entry *, capa);
+        REALLOC_N(poller->events, struct epoll_event, capa < ZMQ_POLLER_MAX_EVENTS ? capa : ZMQ_POLLER_MAX_EVENTS);
+    }
+#endif
+    poller->poll_capa = capa;
 }
 
 /*
  * :nodoc:
- *  Rebuild the readable and writable arrays if any spoll items are in a ready state
+ *  Grows the poller by doubling to fit one more registered item.
+ *
+*/
+static void rb_czmq_poller_reserve(zmq_poll_wrapper *poller)
+{
+    int capa = poller->poll_capa ? poller->poll_capa : 8;
+    if (poller->poll_size < poller->poll_capa) return;
+    while (capa <= poller->poll_size) capa *= 2;
+    rb_czmq_poller_resize(poller, capa);
+}
+
+/*
+ * :nodoc:
+ *  Queues the registrations of a socket with epoll backed pollers, except for the given one, to check ZMQ_EVENTS
+ *  for on their next poll. Only called with the GVL held.
+ *
+*/
+static void rb_czmq_poller_touch(zmq_sock_wrapper *sock, zmq_poll_wrapper *except)
+{
+    zmq_poller_entry *entry = NULL;
+    zmq_poll_wrapper *poller = NULL;
+    for (entry = (zmq_poller_entry *)sock->registrations; entry; entry = entry->next) {
+        poller = (zmq_poll_wrapper *)entry->poller;
+        if (poller == except || entry->touched) continue;
+        entry->touched = true;
+        poller->touched[poller->touched_size++] = entry;
+    }
+}
+
+/*
+ * :nodoc:
+ *  Queues a socket that's been operated on with the epoll backed pollers it's registered with - see ZmqSocketTouched.
+ *
+*/
+void rb_czmq_poller_socket_touched(zmq_sock_wrapper *sock)
+{
+    rb_czmq_poller_touch(sock, NULL);
+}
+
+/*
+ * :nodoc:
+ *  Detaches the registrations of a socket that's being freed, as the pollers they belong to may be freed later
+ *  by the same GC run.
+ *
+*/
+void rb_czmq_poller_socket_freed(zmq_sock_wrapper *sock)
+{
+    zmq_poller_entry *entry = NULL;
+    for (entry = (zmq_poller_entry *)sock->registrations; entry; entry = entry->next) entry->linked = false;
+    sock->registrations = NULL;
+}
+
+/*
+ * :nodoc:
+ *  Fills the ready list from the revents of the pollset after a zmq_poll. Safe to call without the GIL.
+ *
+*/
+static void rb_czmq_poller_collect(zmq_poll_wrapper *poller)
+{
+    int i;
+    poller->ready_size = 0;
+    for (i = 0; i < poller->poll_size; i++) {
+        if (poller->pollset[i].revents == 0) continue;
+        poller->ready[poller->ready_size].pollitem = poller->items[i];
+        poller->ready[poller->ready_size++].revents = poller->pollset[i].revents;
+    }
+}
+
+/*
+ * :nodoc:
+ *  Rebuild the readable and writable arrays from the items found ready by the last poll
  *
 */
 int rb_czmq_poller_rebuild_selectables(zmq_poll_wrapper *poller)
 {
+    zmq_pollitem_wrapper *pollitem = NULL;
     VALUE pollable;
     int rebuilt;
     rb_ary_clear(poller->readables);
     rb_ary_clear(poller->writables);
-    for (rebuilt = 0; rebuilt < poller->poll_size; rebuilt++) {
-        zmq_pollitem_t item = poller->pollset[rebuilt];
-        pollable = rb_ary_entry(poller->pollables, (long)rebuilt);
-        ZmqGetPollitem(pollable);
-        if (item.revents & ZMQ_POLLIN)
-            rb_ary_push(poller->readables, rb_czmq_pollitem_pollable(pollable));
-        if (item.revents & ZMQ_POLLOUT)
-            rb_ary_push(poller->writables, rb_czmq_pollitem_pollable(pollable));
+    poller->selectables_stale = false;
+    for (rebuilt = 0; rebuilt < poller->ready_size; rebuilt++) {
+        pollitem = poller->ready[rebuilt].pollitem;
+        if (!pollitem) continue;
+        pollable = NIL_P(pollitem->socket) ? pollitem->io : pollitem->socket;
+        if (poller->ready[rebuilt].revents & ZMQ_POLLIN)
+            rb_ary_push(poller->readables, pollable);
+        if (poller->ready[rebuilt].revents & ZMQ_POLLOUT)
+            rb_ary_push(poller->writables, pollable);
     }
     return 0;
 }
@@ -90,15 +200,94 @@ VALUE rb_czmq_poller_new(VALUE obj)
     zmq_poll_wrapper *poller = NULL;
     obj = Data_Make_Struct(rb_cZmqPoller, zmq_poll_wrapper, rb_czmq_mark_poller, rb_czmq_free_poller_gc, poller);
     poller->pollset = NULL;
+    poller->items = NULL;
     poller->pollables = rb_ary_new();
     poller->readables = rb_ary_new();
     poller->writables = rb_ary_new();
-    poller->dirty = false;
+    poller->poll_size = 0;
+    poller->poll_capa = 0;
+    poller->index = st_init_numtable();
+    poller->duplicates = 0;
     poller->verbose = false;
-    rb_obj_call_init(obj, 0, NULL);
+    poller->polling = false;
+    poller->iterating = false;
+    poller->selectables_stale = false;
+    poller->backend = ZMQ_POLLER_ZMQ_POLL;
+    poller->ready = NULL;
+    poller->scratch = NULL;
+    poller->prioritized = 0;
+    poller->ready_size = 0;
+    poller->epoll_fd = -1;
+    poller->entries = NULL;
+    poller->pending = NULL;
+    poller->pending_size = 0;
+    poller->touched = NULL;
+    poller->touched_size = 0;
+    poller->generation = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    poller->events = NULL;
+#endif
     return obj;
 }
 
+/*
+ *  call-seq:
+ *     ZMQ::Poller.new(backend: :epoll)    =>  ZMQ::Poller
+ *
+ *  Selects the polling backend. The default :zmq_poll backend passes the whole pollset to zmq_poll on every poll,
+ *  which is O(n) in the number of registered items. The :epoll backend (Linux only) registers the ZMQ_FD of sockets
+ *  and the file descriptors of IOs with an epoll instance once, and only ever looks at items that are ready, which
+ *  makes polling O(ready) and suits large pollsets. A socket may only be registered once with an epoll backed poller -
+ *  register a single poll item for both events instead.
+ *
+ * === Examples
+ *
+ *     ZMQ::Poller.new(backend: :epoll)    =>  ZMQ::Poller
+ *
+*/
+static VALUE rb_czmq_poller_initialize(int argc, VALUE *argv, VALUE obj)
+{
+    VALUE options, backend = Qnil;
+    ZmqGetPoller(obj);
+    rb_scan_args(argc, argv, "01", &options);
+    if (!NIL_P(options)) {
+        Check_Type(options, T_HASH);
+        backend = rb_hash_aref(options, ID2SYM(rb_intern("backend")));
+    }
+    if (NIL_P(backend) || backend == ID2SYM(rb_intern("zmq_poll"))) return Qnil;
+    if (backend != ID2SYM(rb_intern("epoll"))) rb_raise(rb_eArgError, "unsupported poller backend, expected :zmq_poll or :epoll!");
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->poll_size > 0) rb_raise(rb_eZmqError, "cannot change the backend of a poller with registered items!");
+    if (poller->epoll_fd == -1) {
+        poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (poller->epoll_fd == -1) rb_sys_fail("epoll_create1");
+    }
+    poller->backend = ZMQ_POLLER_EPOLL;
+    /* items may have been registered, and removed, already */
+    if (poller->poll_capa > 0) rb_czmq_poller_resize(poller, poller->poll_capa);
+#else
+    rb_raise(rb_eNotImpError, "the epoll poller backend is not supported on this platform!");
+#endif
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     poller.backend    =>  Symbol
+ *
+ *  Returns the polling backend of this poller, either :zmq_poll or :epoll.
+ *
+ * === Examples
+ *
+ *     ZMQ::Poller.new.backend    =>  :zmq_poll
+ *
+*/
+static VALUE rb_czmq_poller_backend(VALUE obj)
+{
+    ZmqGetPoller(obj);
+    return ID2SYM(rb_intern(poller->backend == ZMQ_POLLER_EPOLL ? "epoll" : "zmq_poll"));
+}
+
 /*
  * :nodoc:
  *  Polls a set of sockets / IOs while the GIL is released.
@@ -109,14 +298,325 @@ static VALUE rb_czmq_nogvl_poll(void *ptr)
     struct nogvl_poll_args *args = ptr;
     int rc;
     rc = zmq_poll(args->items, args->nitems, args->timeout);
+    if (rc > 0) {
+        rb_czmq_poller_collect(args->poller);
+        rc = args->poller->ready_size;
+    }
+    return (VALUE)rc;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * :nodoc:
+ *  Queues a socket to check ZMQ_EVENTS for on the next poll, unless queued already.
+ *
+*/
+static void rb_czmq_poller_recheck(zmq_poll_wrapper *poller, zmq_poller_entry *entry)
+{
+    if (entry->pending) return;
+    entry->pending = true;
+    poller->pending[poller->pending_size++] = entry;
+}
+
+/*
+ * :nodoc:
+ *  Appends an item to the ready list, unless it's been reported ready by this poll already. A ready socket won't
+ *  signal again until drained, thus it's rechecked on the next poll.
+ *
+*/
+static void rb_czmq_poller_ready(zmq_poll_wrapper *poller, zmq_poller_entry *entry, short revents)
+{
+    if (revents == 0) return;
+    if (entry->ready_generation == poller->generation) return;
+    entry->ready_generation = poller->generation;
+    poller->ready[poller->ready_size].pollitem = entry->pollitem;
+    poller->ready[poller->ready_size++].revents = revents;
+    if (entry->sock) rb_czmq_poller_recheck(poller, entry);
+}
+
+/*
+ * :nodoc:
+ *  Maps an epoll event to the events of a poll item. The ZMQ_FD of a socket only signals that its state changed, and
+ *  ZMQ_EVENTS tells what it is ready for. IOs map like they do with zmq_poll.
+ *
+*/
+static short rb_czmq_poller_epoll_revents(zmq_poller_entry *entry, uint32_t events)
+{
+    short revents = 0;
+    if (entry->sock) {
+        if (entry->sock->flags & ZMQ_SOCKET_DESTROYED) return 0;
+        return (short)(zsocket_events(entry->sock->socket) & entry->pollitem->item->events);
+    }
+    if (events & EPOLLIN) revents |= ZMQ_POLLIN;
+    if (events & EPOLLOUT) revents |= ZMQ_POLLOUT;
+    if (events & ~(EPOLLIN | EPOLLOUT)) revents |= ZMQ_POLLERR;
+    return revents;
+}
+
+/*
+ * :nodoc:
+ *  Polls the epoll set while the GIL is released. Sockets pending a recheck are looked at first, in which case the
+ *  epoll set is only checked without waiting. Waits again if all sockets that signaled turn out not to be ready,
+ *  until the timeout expires.
+ *
+*/
+static VALUE rb_czmq_nogvl_epoll(void *ptr)
+{
+    struct nogvl_poll_args *args = ptr;
+    zmq_poll_wrapper *poller = args->poller;
+    zmq_poller_entry *entry = NULL;
+    uint64_t now, deadline = 0;
+    int i, rc, wait, pending = poller->pending_size;
+    int max = poller->poll_size < ZMQ_POLLER_MAX_EVENTS ? poller->poll_size : ZMQ_POLLER_MAX_EVENTS;
+    if (args->timeout > 0) deadline = rb_czmq_monotonic_clock() + (uint64_t)args->timeout * 1000000ULL;
+    errno = 0;
+    poller->generation++;
+    poller->ready_size = 0;
+    /* sockets found ready are queued again, never past the entry being checked */
+    poller->pending_size = 0;
+    for (i = 0; i < pending; i++) {
+        entry = poller->pending[i];
+        entry->pending = false;
+        rb_czmq_poller_ready(poller, entry, rb_czmq_poller_epoll_revents(entry, 0));
+    }
+    for (;;) {
+        if (poller->ready_size > 0 || args->timeout == 0) {
+            wait = 0;
+        } else if (args->timeout < 0) {
+            wait = -1;
+        } else {
+            now = rb_czmq_monotonic_clock();
+            wait = (now >= deadline) ? 0 : (int)((deadline - now + 999999ULL) / 1000000ULL);
+        }
+        rc = epoll_wait(poller->epoll_fd, poller->events, max, wait);
+        if (rc == -1) {
+            if (poller->ready_size > 0) break;
+            return (VALUE)-1;
+        }
+        for (i = 0; i < rc; i++) {
+            entry = (zmq_poller_entry *)poller->events[i].data.ptr;
+            rb_czmq_poller_ready(poller, entry, rb_czmq_poller_epoll_revents(entry, poller->events[i].events));
+        }
+        if (poller->ready_size > 0 || wait == 0) break;
+    }
+    return (VALUE)poller->ready_size;
+}
+
+/*
+ * :nodoc:
+ *  Updates the pending list before polling : sockets closed since the last poll are dropped, as ZMQ_EVENTS can't be
+ *  checked on them anymore, and sockets operated on since are added, as that may have consumed the edge of their
+ *  ZMQ_FD. Only looks at sockets queued, never the whole pollset.
+ *
+*/
+static void rb_czmq_poller_update_pending(zmq_poll_wrapper *poller)
+{
+    zmq_poller_entry *entry = NULL;
+    int i = 0;
+    while (i < poller->pending_size) {
+        entry = poller->pending[i];
+        if (entry->sock->flags & ZMQ_SOCKET_DESTROYED) {
+            entry->pending = false;
+            poller->pending[i] = poller->pending[--poller->pending_size];
+        } else {
+            i++;
+        }
+    }
+    for (i = 0; i < poller->touched_size; i++) {
+        entry = poller->touched[i];
+        entry->touched = false;
+        if (!(entry->sock->flags & ZMQ_SOCKET_DESTROYED)) rb_czmq_poller_recheck(poller, entry);
+    }
+    poller->touched_size = 0;
+}
+#endif
+
+/*
+ * :nodoc:
+ *  Stable merge sort of the ready list by priority, lowest first. Runs without the GIL.
+ *
+*/
+static void rb_czmq_poller_sort_ready(zmq_poll_ready *ready, zmq_poll_ready *scratch, int size)
+{
+    int mid = size / 2, left = 0, right = mid, i = 0;
+    if (size < 2) return;
+    rb_czmq_poller_sort_ready(ready, scratch, mid);
+    rb_czmq_poller_sort_ready(ready + mid, scratch, size - mid);
+    if (ready[mid - 1].pollitem->priority <= ready[mid].pollitem->priority) return;
+    while (left < mid && right < size) {
+        if (ready[right].pollitem->priority < ready[left].pollitem->priority) {
+            scratch[i++] = ready[right++];
+        } else {
+            scratch[i++] = ready[left++];
+        }
+    }
+    while (left < mid) scratch[i++] = ready[left++];
+    while (right < size) scratch[i++] = ready[right++];
+    MEMCPY(ready, scratch, zmq_poll_ready, size);
+}
+
+/*
+ * :nodoc:
+ *  Receives from sockets found ready for reading, up to max times their weight messages each. Items of a higher
+ *  priority are drained first, and items of the same priority round robin, up to weight messages each per round.
+ *  Runs without the GIL and thus uses the system allocator. Nothing is received if any of the ready sockets belongs
+ *  to another thread. Sockets with a deferred receive error are skipped, and receiving goes on with the other sockets
+ *  if one defers an error.
+ *
+*/
+static void rb_czmq_poller_drain(zmq_poll_wrapper *poller, struct nogvl_poll_recv_args *recv)
+{
+    zmq_poll_ready *ready = NULL;
+    zmq_sock_wrapper *sock = NULL;
+    long quota, limit, received;
+    int first, last, i, active;
+    for (i = 0; i < poller->ready_size; i++) {
+        ready = &poller->ready[i];
+        ready->received = 0;
+        ready->drained = !(ready->revents & ZMQ_POLLIN) || NIL_P(ready->pollitem->socket);
+        if (ready->drained) continue;
+        sock = (zmq_sock_wrapper *)DATA_PTR(ready->pollitem->socket);
+        if (sock->thread != recv->thread) {
+            recv->foreign = sock;
+            return;
+        }
+        if (sock->recv_error) ready->drained = true;
+    }
+    for (first = 0; first < poller->ready_size; first = last) {
+        for (last = first; last < poller->ready_size; last++) {
+            if (poller->ready[last].pollitem->priority != poller->ready[first].pollitem->priority) break;
+        }
+        do {
+            active = 0;
+            for (i = first; i < last; i++) {
+                ready = &poller->ready[i];
+                if (ready->drained) continue;
+                limit = (recv->max > LONG_MAX / ready->pollitem->weight) ? LONG_MAX : recv->max * ready->pollitem->weight;
+                quota = limit - ready->received;
+                if (quota > ready->pollitem->weight) quota = ready->pollitem->weight;
+                sock = (zmq_sock_wrapper *)DATA_PTR(ready->pollitem->socket);
+                received = rb_czmq_recv_batch_drain(&recv->batch, sock, quota, ZMQ_DONTWAIT, i);
+                /* out of memory between messages - leave the rest queued */
+                if (recv->batch.error == ENOMEM) return;
+                ready->received += received;
+                if (received < quota || ready->received >= limit || sock->recv_error) {
+                    ready->drained = true;
+                } else {
+                    active++;
+                }
+            }
+        } while (active > 0);
+    }
+}
+
+/*
+ * :nodoc:
+ *  Polls with the backend of the poller while the GIL is released, receiving from ready sockets as well if asked to.
+ *
+*/
+static VALUE rb_czmq_nogvl_poller_wait(void *ptr)
+{
+    struct nogvl_poll_args *args = ptr;
+    int rc;
+    errno = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    if (args->poller->backend == ZMQ_POLLER_EPOLL) {
+        rc = (int)rb_czmq_nogvl_epoll(ptr);
+    } else
+#endif
+    rc = (int)rb_czmq_nogvl_poll(ptr);
+    if (rc > 1 && args->poller->prioritized > 0)
+        rb_czmq_poller_sort_ready(args->poller->ready, args->poller->scratch, args->poller->ready_size);
+    if (rc > 0 && args->recv) rb_czmq_poller_drain(args->poller, args->recv);
     return (VALUE)rc;
 }
 
+/*
+ * :nodoc:
+ *  Releases the GIL for the duration of a poll. Pending interrupts are left to the caller, to check once messages
+ *  received are built.
+ *
+*/
+static VALUE rb_czmq_poller_wait_body(VALUE ptr)
+{
+    return (VALUE)rb_thread_call_without_gvl2(rb_czmq_nogvl_poller_wait, (void *)ptr, RUBY_UBF_IO, 0);
+}
+
+/*
+ * :nodoc:
+ *  Marks the poller idle again, also when an interrupt raises once the GIL is reacquired. Checking ZMQ_EVENTS, and
+ *  receiving, may have consumed the edge of the ZMQ_FD of sockets found ready, thus they're queued with any other
+ *  epoll backed pollers they're registered with.
+ *
+*/
+static VALUE rb_czmq_poller_wait_ensure(VALUE ptr)
+{
+    zmq_poll_wrapper *poller = (zmq_poll_wrapper *)ptr;
+    zmq_pollitem_wrapper *pollitem = NULL;
+    zmq_sock_wrapper *sock = NULL;
+    int i;
+    poller->polling = false;
+    for (i = 0; i < poller->ready_size; i++) {
+        pollitem = poller->ready[i].pollitem;
+        if (!pollitem || NIL_P(pollitem->socket)) continue;
+        Data_Get_Struct(pollitem->socket, zmq_sock_wrapper, sock);
+        if (sock->registrations && !(sock->flags & ZMQ_SOCKET_DESTROYED)) rb_czmq_poller_touch(sock, poller);
+    }
+    return Qnil;
+}
+
+/*
+ * :nodoc:
+ *  Polls for ready items with the GIL released and fills the ready list. Returns the number of ready items, or -1
+ *  on errors, to be checked with ZmqAssertPolled once any resources are released.
+ *
+*/
+static int rb_czmq_poller_wait(zmq_poll_wrapper *poller, VALUE tmout, struct nogvl_poll_recv_args *recv)
+{
+    size_t timeout;
+    struct nogvl_poll_args args;
+    int rc;
+    if (poller->poll_size == 0) return 0;
+    timeout = (size_t)(((TYPE(tmout) == T_FIXNUM) ? FIX2LONG(tmout) : RFLOAT_VALUE(tmout)) * 1000); 
+    if (timeout < 0) timeout = -1;
+
+    args.items = poller->pollset;
+    args.nitems = poller->poll_size;
+    args.timeout = (long)timeout;
+    args.poller = poller;
+    args.recv = recv;
+
+    poller->ready_size = 0;
+    poller->selectables_stale = true;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->backend == ZMQ_POLLER_EPOLL) rb_czmq_poller_update_pending(poller);
+#endif
+    poller->polling = true;
+    rc = (int)rb_ensure(rb_czmq_poller_wait_body, (VALUE)&args, rb_czmq_poller_wait_ensure, (VALUE)poller);
+    return rc;
+}
+
+/*
+ * :nodoc:
+ *  Validates the poll timeout and the state of the poller before polling.
+ *
+*/
+static VALUE rb_czmq_poller_check(zmq_poll_wrapper *poller, VALUE tmout)
+{
+    if (NIL_P(tmout)) tmout = INT2NUM(0);
+    if (TYPE(tmout) != T_FIXNUM && TYPE(tmout) != T_FLOAT) rb_raise(rb_eTypeError, "wrong timeout type %s (expected Fixnum or Float)", RSTRING_PTR(rb_obj_as_string(tmout)));
+    ZmqAssertPollerIdle(poller);
+    ZmqAssertPollerNotIterating(poller);
+    return tmout;
+}
+
 /*
  *  call-seq:
  *     poller.poll(1)    =>  Fixnum
  *
- *  Multiplexes input/output events in a level-triggered fashion over a set of registered sockets.
+ *  Multiplexes input/output events in a level-triggered fashion over a set of registered sockets. Returns the number of
+ *  items in a ready state.
  *
  * === Examples
  *
@@ -135,44 +635,183 @@ static VALUE rb_czmq_nogvl_poll(void *ptr)
 VALUE rb_czmq_poller_poll(int argc, VALUE *argv, VALUE obj)
 {
     VALUE tmout;
-    size_t timeout;
-    struct nogvl_poll_args args;
     int rc;
     ZmqGetPoller(obj);
     rb_scan_args(argc, argv, "01", &tmout);
-    if (NIL_P(tmout)) tmout = INT2NUM(0);
-    if (TYPE(tmout) != T_FIXNUM && TYPE(tmout) != T_FLOAT) rb_raise(rb_eTypeError, "wrong timeout type %s (expected Fixnum or Float)", RSTRING_PTR(rb_obj_as_string(tmout)));
-    if (poller->poll_size == 0) return INT2NUM(0);
-    if (poller->dirty == true) {
-        rc = rb_czmq_poller_rebuild_pollset(poller);
-        if (rc == -1) rb_raise(rb_eZmqError, "failed in rebuilding the pollset!");
+    tmout = rb_czmq_poller_check(poller, tmout);
+    rc = rb_czmq_poller_wait(poller, tmout, NULL);
+    ZmqAssertPolled(rc);
+    rb_thread_check_ints();
+    return INT2NUM(rc);
+}
+
+/*
+ * :nodoc:
+ *  Raises the receive error a socket of the last poll's ready list deferred, if any.
+ *
+*/
+static void rb_czmq_poller_raise_deferred(zmq_poll_wrapper *poller)
+{
+    zmq_pollitem_wrapper *pollitem = NULL;
+    zmq_sock_wrapper *sock = NULL;
+    int i;
+    for (i = 0; i < poller->ready_size; i++) {
+        pollitem = poller->ready[i].pollitem;
+        if (!pollitem || NIL_P(pollitem->socket)) continue;
+        Data_Get_Struct(pollitem->socket, zmq_sock_wrapper, sock);
+        if (sock->flags & ZMQ_SOCKET_DESTROYED) continue;
+        ZmqAssertNoDeferredRecvError(sock);
     }
-    timeout = (size_t)(((TYPE(tmout) == T_FIXNUM) ? FIX2LONG(tmout) : RFLOAT_VALUE(tmout)) * 1000); 
-    if (timeout < 0) timeout = -1;
+}
 
-    args.items = poller->pollset;
-    args.nitems = poller->poll_size;
-    args.timeout = (long)timeout;
+/*
+ * :nodoc:
+ *  Polls, receives and builds the [socket, message] pairs received, with the batch released by an ensure callback.
+ *
+*/
+static VALUE rb_czmq_poller_poll_recv_body(VALUE ptr)
+{
+    struct poll_recv_args *args = (struct poll_recv_args *)ptr;
+    zmq_poll_wrapper *poller = args->poller;
+    zmq_recv_batch *batch = &args->recv.batch;
+    zmq_pollitem_wrapper *pollitem = NULL;
+    zmq_sock_wrapper *sock = NULL;
+    VALUE result;
+    long i, frame = 0;
+    args->rc = rb_czmq_poller_wait(poller, args->timeout, &args->recv);
+    if (args->rc < 0 || args->recv.foreign) return Qnil;
+    for (i = 0; i < batch->nframes; i++) {
+        Data_Get_Struct(poller->ready[batch->owners[i]].pollitem->socket, zmq_sock_wrapper, sock);
+        ZmqStatsReceived(sock, 1, zmq_msg_size(&batch->frames[i]));
+        ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&batch->frames[i]), zmq_msg_size(&batch->frames[i]));
+    }
+    result = rb_ary_new2(batch->messages);
+    while (frame < batch->nframes) {
+        pollitem = poller->ready[batch->owners[frame]].pollitem;
+        rb_ary_push(result, rb_assoc_new(pollitem->socket, rb_czmq_recv_batch_message(batch, &frame)));
+    }
+    return result;
+}
 
-    rb_ary_clear(poller->readables);
-    rb_ary_clear(poller->writables);
+/*
+ *  call-seq:
+ *     poller.poll_recv(1)        =>  Array
+ *     poller.poll_recv(1, 10)    =>  Array
+ *
+ *  Polls like #poll and then receives up to max_per_socket (1 by default) times their weight messages from each socket
+ *  found ready for reading, all with a single GVL release. Sockets of a higher priority are drained first, and sockets
+ *  of the same priority round robin, weight messages each per round. Returns an Array of [socket, message] pairs in
+ *  the order received, with single part messages as Strings and multipart messages as an Array of Strings. IOs are
+ *  polled, but not read from - see #each_ready.
+ *
+ *  As with ZMQ::Socket#recv_batch, a message a socket drops (a payload not framed for compression, or out of memory)
+ *  doesn't affect messages received from other sockets: the error is raised if nothing has been received, and by the
+ *  next call otherwise. Raises if a socket found ready has been created by another thread, without receiving anything.
+ *
+ * === Examples
+ *
+ *     poller = ZMQ::Poller.new                          =>  ZMQ::Poller
+ *     poller.register(ZMQ::Pollitem(rep, ZMQ::POLLIN))  =>  true
+ *     poller.poll_recv(1, 10)                           =>  [[rep, "request"], [rep, ["multi", "part"]]]
+ *
+*/
+static VALUE rb_czmq_poller_poll_recv(int argc, VALUE *argv, VALUE obj)
+{
+    VALUE tmout, max, result;
+    struct poll_recv_args args;
+    ZmqGetPoller(obj);
+    rb_scan_args(argc, argv, "02", &tmout, &max);
+    tmout = rb_czmq_poller_check(poller, tmout);
+    if (NIL_P(max)) max = INT2FIX(1);
+    Check_Type(max, T_FIXNUM);
+    if (FIX2LONG(max) <= 0) rb_raise(rb_eArgError, "messages per socket must be greater than zero!");
+    /* messages dropped while receiving others last time are raised before receiving any more */
+    rb_czmq_poller_raise_deferred(poller);
+    args.poller = poller;
+    args.timeout = tmout;
+    args.rc = 0;
+    args.recv.max = FIX2LONG(max);
+    args.recv.thread = rb_thread_current();
+    args.recv.foreign = NULL;
+    rb_czmq_recv_batch_init(&args.recv.batch);
 
-    rc = (int)rb_thread_call_without_gvl(rb_czmq_nogvl_poll, (void *)&args, RUBY_UBF_IO, 0);
+    result = rb_ensure(rb_czmq_poller_poll_recv_body, (VALUE)&args, rb_czmq_recv_batch_free, (VALUE)&args.recv.batch);
+    if (args.recv.foreign) ZmqSockGuardCrossThread(args.recv.foreign);
+    if (args.rc < 0) {
+        ZmqAssertPolled(args.rc);
+        rb_thread_check_ints();
+        return rb_ary_new();
+    }
+    /* interrupts raise once messages received are built, and the batch released */
+    rb_thread_check_ints();
+    if (args.recv.batch.messages == 0) {
+        rb_czmq_poller_raise_deferred(poller);
+        if (args.recv.batch.error == ENOMEM) rb_memerror();
+        errno = args.recv.batch.error;
+        if (args.recv.batch.error && args.recv.batch.error != EINTR) ZmqRaiseSysError();
+    }
+    return result;
+}
 
-    /* only call ZmqAssert if return code is less than zero since zmq_poll returns the number of pollers on success */
-    if (rc < 0) {
-        if (zmq_errno() == EINTR || zmq_errno() == EAGAIN) {
-            // these are recoverable errors, so return flow to ruby so that retry / interrupt handling can be
-            // done in ruby code. Ruby will see a -1 result. If it was an INT (or other) signal, ruby's signal
-            // handler will raise the Interrupt exception.
-        } else {
-            ZmqAssert(rc);
-        }
+/*
+ * :nodoc:
+ *  Compacts the ready list after iterating over it, dropping items removed from within the block.
+ *
+*/
+static VALUE rb_czmq_poller_each_ready_ensure(VALUE obj)
+{
+    int i, ready = 0;
+    ZmqGetPoller(obj);
+    poller->iterating = false;
+    for (i = 0; i < poller->ready_size; i++) {
+        if (poller->ready[i].pollitem) poller->ready[ready++] = poller->ready[i];
     }
-    if (rc > 0) {
-        rb_czmq_poller_rebuild_selectables(poller);
+    poller->ready_size = ready;
+    return Qnil;
+}
+
+/*
+ * :nodoc:
+ *  Yields each ready item of the last poll
+ *
+*/
+static VALUE rb_czmq_poller_each_ready_yield(VALUE obj)
+{
+    zmq_pollitem_wrapper *pollitem = NULL;
+    int i;
+    ZmqGetPoller(obj);
+    for (i = 0; i < poller->ready_size; i++) {
+        pollitem = poller->ready[i].pollitem;
+        if (!pollitem) continue;
+        rb_yield_values(2, NIL_P(pollitem->socket) ? pollitem->io : pollitem->socket, INT2FIX(poller->ready[i].revents));
     }
-    return INT2NUM(rc);
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     poller.each_ready {|pollable, events| }    =>  nil
+ *
+ *  Yields each socket or IO found ready by the last poll, in priority order, along with its ready events (a
+ *  ZMQ::POLLIN, ZMQ::POLLOUT and ZMQ::POLLERR bitmask), straight from the native ready list. Unlike #readables and
+ *  #writables, no Arrays are built. Items may be removed from within the block, but polling again raises.
+ *
+ * === Examples
+ *
+ *     poller = ZMQ::Poller.new                          =>  ZMQ::Poller
+ *     poller.register(ZMQ::Pollitem(req, ZMQ::POLLIN))  =>  true
+ *     poller.poll(1)                                    =>  1
+ *     poller.each_ready{|s,e| s.recv }                 =>  nil
+ *
+*/
+static VALUE rb_czmq_poller_each_ready(VALUE obj)
+{
+    ZmqGetPoller(obj);
+    rb_need_block();
+    ZmqAssertPollerNotIterating(poller);
+    poller->iterating = true;
+    rb_ensure(rb_czmq_poller_each_ready_yield, obj, rb_czmq_poller_each_ready_ensure, obj);
+    return Qnil;
 }
 
 /*
@@ -199,17 +838,139 @@ VALUE rb_czmq_poller_poll(int argc, VALUE *argv, VALUE obj)
 */
 VALUE rb_czmq_poller_register(VALUE obj, VALUE pollable)
 {
+    int slot;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event event;
+    zmq_poller_entry *entry = NULL;
+    int fd, err;
+#endif
     ZmqGetPoller(obj);
+    ZmqAssertPollerIdle(poller);
     pollable = rb_czmq_pollitem_coerce(pollable);
     ZmqGetPollitem(pollable);
+    /* allocate upfront, so nothing raises once registered with epoll */
+    rb_czmq_poller_reserve(poller);
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->backend == ZMQ_POLLER_EPOLL) {
+        if (st_lookup(poller->index, (st_data_t)rb_czmq_pollitem_pollable(pollable), NULL))
+            rb_raise(rb_eZmqError, "pollable already registered with this poller - register a single poll item for all events instead!");
+        entry = ALLOC(zmq_poller_entry);
+        entry->pollitem = pollitem;
+        entry->sock = NIL_P(pollitem->socket) ? NULL : (zmq_sock_wrapper *)DATA_PTR(pollitem->socket);
+        entry->poller = poller;
+        entry->ready_generation = 0;
+        entry->pending = false;
+        entry->touched = false;
+        entry->linked = false;
+        entry->prev = NULL;
+        entry->next = NULL;
+        MEMZERO(&event, struct epoll_event, 1);
+        event.data.ptr = entry;
+        if (entry->sock) {
+            fd = zsocket_fd(entry->sock->socket);
+            event.events = EPOLLIN | EPOLLET;
+        } else {
+            fd = pollitem->item->fd;
+            if (pollitem->item->events & ZMQ_POLLIN) event.events |= EPOLLIN;
+            if (pollitem->item->events & ZMQ_POLLOUT) event.events |= EPOLLOUT;
+        }
+        /* registered by a duplicate, which keeps the number from being reused by another file if the socket or IO
+           is closed while registered - removing it can't deregister an unrelated file */
+        entry->fd = dup(fd);
+        if (entry->fd == -1) {
+            xfree(entry);
+            rb_sys_fail("dup");
+        }
+        if (epoll_ctl(poller->epoll_fd, EPOLL_CTL_ADD, entry->fd, &event) == -1) {
+            err = errno;
+            close(entry->fd);
+            xfree(entry);
+            errno = err;
+            rb_sys_fail("epoll_ctl");
+        }
+    }
+#endif
     /* Let pollable item be verbose if poller is verbose */
     if (poller->verbose == true) rb_czmq_pollitem_set_verbose(pollable, Qtrue);
+    slot = poller->poll_size++;
     rb_ary_push(poller->pollables, pollable);
-    poller->poll_size++;
-    poller->dirty = true;
+    poller->pollset[slot] = *pollitem->item;
+    poller->items[slot] = pollitem;
+    if (pollitem->priority != 0) poller->prioritized++;
+    if (st_lookup(poller->index, (st_data_t)rb_czmq_pollitem_pollable(pollable), NULL)) {
+        poller->duplicates++;
+    } else {
+        st_insert(poller->index, (st_data_t)rb_czmq_pollitem_pollable(pollable), (st_data_t)slot);
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->backend == ZMQ_POLLER_EPOLL) {
+        poller->entries[slot] = entry;
+        if (entry->sock) {
+            entry->next = (zmq_poller_entry *)entry->sock->registrations;
+            if (entry->next) entry->next->prev = entry;
+            entry->sock->registrations = entry;
+            entry->linked = true;
+            /* messages already queued won't signal the ZMQ_FD */
+            rb_czmq_poller_recheck(poller, entry);
+        }
+    }
+#endif
     return pollable;
 }
 
+/*
+ * :nodoc:
+ *  Drops all references to a poll item that's being removed from a slot - it may be collected once removed.
+ *
+*/
+static void rb_czmq_poller_forget(zmq_poll_wrapper *poller, int slot, VALUE pollable)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event event;
+    zmq_poller_entry *entry = NULL;
+#endif
+    int i = 0;
+    ZmqGetPollitem(pollable);
+#ifdef HAVE_SYS_EPOLL_H
+    if (poller->backend == ZMQ_POLLER_EPOLL) {
+        entry = poller->entries[slot];
+        /* the duplicate is still open even if the socket or IO has been closed, thus always removes this entry before
+           the entry its events point to is freed */
+        epoll_ctl(poller->epoll_fd, EPOLL_CTL_DEL, entry->fd, &event);
+        close(entry->fd);
+        while (i < poller->pending_size) {
+            if (poller->pending[i] == entry) {
+                poller->pending[i] = poller->pending[--poller->pending_size];
+            } else {
+                i++;
+            }
+        }
+        i = 0;
+        while (i < poller->touched_size) {
+            if (poller->touched[i] == entry) {
+                poller->touched[i] = poller->touched[--poller->touched_size];
+            } else {
+                i++;
+            }
+        }
+        rb_czmq_poller_unlink(entry);
+        xfree(entry);
+        poller->entries[slot] = NULL;
+    }
+#endif
+    i = 0;
+    while (i < poller->ready_size) {
+        if (poller->ready[i].pollitem == pollitem && poller->iterating) {
+            poller->ready[i++].pollitem = NULL;
+        } else if (poller->ready[i].pollitem == pollitem) {
+            MEMMOVE(&poller->ready[i], &poller->ready[i + 1], zmq_poll_ready, poller->ready_size - i - 1);
+            poller->ready_size--;
+        } else {
+            i++;
+        }
+    }
+}
+
 /*
  *  call-seq:
  *     poller.remove(pollitem)    =>  boolean
@@ -226,28 +987,48 @@ VALUE rb_czmq_poller_register(VALUE obj, VALUE pollable)
 */
 VALUE rb_czmq_poller_remove(VALUE obj, VALUE pollable)
 {
-    int pos;
-    VALUE rpollable;
+    st_data_t key, slot;
+    int pos, last;
+    VALUE rpollable, moved;
     ZmqGetPoller(obj);
+    ZmqAssertPollerIdle(poller);
     pollable = rb_czmq_pollitem_coerce(pollable);
-    ZmqGetPollitem(pollable);
-    for (pos = 0; pos < poller->poll_size; pos++) {
-        rpollable = rb_ary_entry(poller->pollables, (long)pos);
-        if (pollable == rpollable || rb_czmq_pollitem_pollable(pollable) == rb_czmq_pollitem_pollable(rpollable)) {
-            rb_ary_delete(poller->pollables, rpollable);
-            poller->poll_size--;
-            poller->dirty = true;
-            return rpollable;
+    key = (st_data_t)rb_czmq_pollitem_pollable(pollable);
+    if (!st_delete(poller->index, &key, &slot)) return Qfalse;
+    rpollable = rb_ary_entry(poller->pollables, (long)slot);
+    rb_czmq_poller_forget(poller, (int)slot, rpollable);
+    if (poller->items[slot]->priority != 0) poller->prioritized--;
+    /* swap the last registered item into the vacated slot */
+    last = --poller->poll_size;
+    if ((int)slot != last) {
+        moved = rb_ary_entry(poller->pollables, (long)last);
+        rb_ary_store(poller->pollables, (long)slot, moved);
+        poller->pollset[slot] = poller->pollset[last];
+        poller->items[slot] = poller->items[last];
+        if (poller->entries) poller->entries[slot] = poller->entries[last];
+        if (st_lookup(poller->index, (st_data_t)rb_czmq_pollitem_pollable(moved), &key) && (int)key == last)
+            st_insert(poller->index, (st_data_t)rb_czmq_pollitem_pollable(moved), slot);
+    }
+    rb_ary_pop(poller->pollables);
+    /* the same pollable registered more than once - index the next registration */
+    if (poller->duplicates > 0) {
+        key = (st_data_t)rb_czmq_pollitem_pollable(rpollable);
+        for (pos = 0; pos < poller->poll_size; pos++) {
+            if (rb_czmq_pollitem_pollable(rb_ary_entry(poller->pollables, (long)pos)) == (VALUE)key) {
+                st_insert(poller->index, key, (st_data_t)pos);
+                poller->duplicates--;
+                break;
+            }
         }
     }
-    return Qfalse;
+    return rpollable;
 }
 
 /*
  *  call-seq:
  *     poller.readables    =>  Array
  *
- *  All poll items in a readable state after the last poll.
+ *  All poll items in a readable state after the last poll. Built on first access after a poll.
  *
  * === Examples
  *
@@ -260,6 +1041,7 @@ VALUE rb_czmq_poller_remove(VALUE obj, VALUE pollable)
 VALUE rb_czmq_poller_readables(VALUE obj)
 {
     ZmqGetPoller(obj);
+    if (poller->selectables_stale) rb_czmq_poller_rebuild_selectables(poller);
     return poller->readables;
 }
 
@@ -267,7 +1049,7 @@ VALUE rb_czmq_poller_readables(VALUE obj)
  *  call-seq:
  *     poller.writables    =>  Array
  *
- *  All poll items in a writable state after the last poll.
+ *  All poll items in a writable state after the last poll. Built on first access after a poll.
  *
  * === Examples
  *
@@ -280,6 +1062,7 @@ VALUE rb_czmq_poller_readables(VALUE obj)
 VALUE rb_czmq_poller_writables(VALUE obj)
 {
     ZmqGetPoller(obj);
+    if (poller->selectables_stale) rb_czmq_poller_rebuild_selectables(poller);
     return poller->writables;
 }
 
@@ -309,9 +1092,13 @@ void _init_rb_czmq_poller()
     rb_cZmqPoller = rb_define_class_under(rb_mZmq, "Poller", rb_cObject);
 
     rb_define_alloc_func(rb_cZmqPoller, rb_czmq_poller_new);
+    rb_define_method(rb_cZmqPoller, "initialize", rb_czmq_poller_initialize, -1);
+    rb_define_method(rb_cZmqPoller, "backend", rb_czmq_poller_backend, 0);
     rb_define_method(rb_cZmqPoller, "poll", rb_czmq_poller_poll, -1);
+    rb_define_method(rb_cZmqPoller, "poll_recv", rb_czmq_poller_poll_recv, -1);
     rb_define_method(rb_cZmqPoller, "register", rb_czmq_poller_register, 1);
     rb_define_method(rb_cZmqPoller, "remove", rb_czmq_poller_remove, 1);
+    rb_define_method(rb_cZmqPoller, "each_ready", rb_czmq_poller_each_ready, 0);
     rb_define_method(rb_cZmqPoller, "readables", rb_czmq_poller_readables, 0);
     rb_define_method(rb_cZmqPoller, "writables", rb_czmq_poller_writables, 0);
     rb_define_method(rb_cZmqPoller, "verbose=", rb_czmq_poller_set_verbose, 1);
@@ -1,14 +1,77 @@
 #ifndef RBCZMQ_POLLER_H
 #define RBCZMQ_POLLER_H
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#define ZMQ_POLLER_ZMQ_POLL 0
+#define ZMQ_POLLER_EPOLL 1
+
+/* Upper bound of events fetched per epoll_wait - edge triggered events not fetched stay queued for the next call */
+#define ZMQ_POLLER_MAX_EVENTS 1024
+
+/* Registration of an item with an epoll backed poller. Epoll events point to it, thus it's allocated once and doesn't
+   move along with its slot. The same poll item may be registered with several pollers, and the registrations of a
+   socket are linked from it, for operations on the socket to queue a recheck with each of them. */
+typedef struct zmq_poller_entry_s {
+    zmq_pollitem_wrapper *pollitem;
+    zmq_sock_wrapper *sock; /* NULL for IOs */
+    void *poller; /* zmq_poll_wrapper - defined below */
+    int fd; /* duplicate of the ZMQ_FD of a socket, or of the file descriptor of an IO */
+    unsigned long ready_generation; /* poll that last reported this item ready */
+    bool pending;
+    bool touched;
+    bool linked; /* cleared once the socket is freed, which may happen before the poller in the same GC run */
+    struct zmq_poller_entry_s *prev;
+    struct zmq_poller_entry_s *next;
+} zmq_poller_entry;
+
+typedef struct {
+    zmq_pollitem_wrapper *pollitem;
+    short revents;
+    long received; /* messages received by ZMQ::Poller#poll_recv */
+    bool drained;
+} zmq_poll_ready;
+
 typedef struct {
     VALUE pollables;
     VALUE readables;
     VALUE writables;
+    /* pollset and pollables are kept in the same slot order, with the slot of each pollable indexed for O(1) removal */
     zmq_pollitem_t *pollset;
+    zmq_pollitem_wrapper **items;
     int poll_size;
-    bool dirty;
+    int poll_capa;
+    st_table *index;
+    int duplicates;
+    /* registered items with a non-default priority - the ready list is only sorted if any */
+    int prioritized;
     bool verbose;
+    bool polling;
+    bool iterating;
+    /* readables and writables are only rebuilt from the ready list when asked for after a poll */
+    bool selectables_stale;
+    int backend;
+    /* items found ready by the last poll, sized for all registered items as it's filled without the GVL */
+    zmq_poll_ready *ready;
+    zmq_poll_ready *scratch;
+    int ready_size;
+    /* epoll backend: registrations in slot order, and sockets to check ZMQ_EVENTS for on the next poll, as their edge
+       triggered ZMQ_FD won't signal messages that were already queued when registered, left unread after being
+       reported ready or found by any operation on the socket since the last poll */
+    int epoll_fd;
+    zmq_poller_entry **entries;
+    zmq_poller_entry **pending;
+    int pending_size;
+    /* sockets operated on since the last poll, queued with the GVL held - possibly while polling in another thread -
+       and moved to the pending list before the next poll */
+    zmq_poller_entry **touched;
+    int touched_size;
+    unsigned long generation;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event *events;
+#endif
 } zmq_poll_wrapper;
 
 #define ZmqAssertPoller(obj) ZmqAssertType(obj, rb_cZmqPoller, "ZMQ::Poller")
@@ -18,12 +81,44 @@ typedef struct {
     Data_Get_Struct(obj, zmq_poll_wrapper, poller); \
     if (!poller) rb_raise(rb_eTypeError, "uninitialized ZMQ poller!");
 
+#define ZmqAssertPollerIdle(poller) \
+    if ((poller)->polling) rb_raise(rb_eZmqError, "cannot change the pollset while polling!");
+
+#define ZmqAssertPollerNotIterating(poller) \
+    if ((poller)->iterating) rb_raise(rb_eZmqError, "cannot poll while iterating over ready items!");
+
+/* EINTR and EAGAIN return flow to Ruby for retry / interrupt handling: Ruby sees a -1 result and its signal handler
+   raises Interrupt for an INT signal. Polls return the number of ready items on success. */
+#define ZmqAssertPolled(rc) \
+    if ((rc) < 0 && zmq_errno() != EINTR && zmq_errno() != EAGAIN) { \
+        ZmqAssert(rc); \
+    }
+
+struct nogvl_poll_recv_args {
+    long max;
+    VALUE thread; /* the polling thread, which may only receive from sockets it created */
+    zmq_sock_wrapper *foreign; /* a ready socket of another thread, in which case nothing is received */
+    zmq_recv_batch batch; /* owners are the ready list entries frames have been received from */
+};
+
 struct nogvl_poll_args {
     zmq_pollitem_t *items;
     int nitems;
     long timeout;
+    zmq_poll_wrapper *poller;
+    struct nogvl_poll_recv_args *recv; /* receive from ready sockets as well if set */
+};
+
+struct poll_recv_args {
+    zmq_poll_wrapper *poller;
+    VALUE timeout;
+    int rc;
+    struct nogvl_poll_recv_args recv;
 };
 
+void rb_czmq_poller_socket_touched(zmq_sock_wrapper *sock);
+void rb_czmq_poller_socket_freed(zmq_sock_wrapper *sock);
+
 void _init_rb_czmq_poller();
 
 #endif
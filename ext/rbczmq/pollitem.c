@@ -33,11 +33,15 @@ void rb_czmq_free_pollitem_gc(void *ptr)
 /*
  *  call-seq:
  *     ZMQ::Pollitem.new(io, ZMQ:POLLIN)    =>  ZMQ::Pollitem
+ *     ZMQ::Pollitem.new(sock, ZMQ:POLLIN, priority: 0, weight: 4)    =>  ZMQ::Pollitem
  *
  *  A generic poll item that supports Ruby I/O objects as well as native ZMQ sockets. Poll items are primarily used
  *  for registering pollable entities with ZMQ::Poller and ZMQ::Loop instances. If no events given, we default to
  *  observing both readable and writable state.
  *
+ *  ZMQ::Poller returns ready items in priority order, lowest value first (0 by default). ZMQ::Poller#poll_recv drains
+ *  ready sockets of the same priority round robin, receiving up to weight (1 by default) messages from each per round.
+ *
  * === Examples
  *
  *  Supported pollable types :
@@ -53,15 +57,30 @@ void rb_czmq_free_pollitem_gc(void *ptr)
  *     ZMQ::Pollitem.new(io)                    =>  ZMQ::Pollitem
  *     ZMQ::Pollitem.new(io, ZMQ:POLLIN)        =>  ZMQ::Pollitem
  *     ZMQ::Pollitem.new(socket, ZMQ:POLLOUT)   =>  ZMQ::Pollitem
+ *     ZMQ::Pollitem.new(socket, ZMQ:POLLIN, priority: 1, weight: 4)   =>  ZMQ::Pollitem
  *
 */
 static VALUE rb_czmq_pollitem_s_new(int argc, VALUE *argv, VALUE obj)
 {
     zmq_sock_wrapper *sock = NULL;
-    VALUE pollable, events;
+    VALUE pollable, events, options, priority = Qnil, weight = Qnil;
     int evts;
     zmq_pollitem_wrapper *pollitem = NULL;
-    rb_scan_args(argc, argv, "11", &pollable, &events);
+    rb_scan_args(argc, argv, "12", &pollable, &events, &options);
+    if (TYPE(events) == T_HASH && NIL_P(options)) {
+        options = events;
+        events = Qnil;
+    }
+    if (!NIL_P(options)) {
+        Check_Type(options, T_HASH);
+        priority = rb_hash_aref(options, ID2SYM(rb_intern("priority")));
+        weight = rb_hash_aref(options, ID2SYM(rb_intern("weight")));
+        if (!NIL_P(priority)) Check_Type(priority, T_FIXNUM);
+        if (!NIL_P(weight)) {
+            Check_Type(weight, T_FIXNUM);
+            if (FIX2LONG(weight) <= 0 || FIX2LONG(weight) > INT_MAX) rb_raise(rb_eArgError, "weight must be a positive integer!");
+        }
+    }
     if (NIL_P(events)) events = INT2NUM((ZMQ_POLLIN | ZMQ_POLLOUT));
     Check_Type(events, T_FIXNUM);
     evts = NUM2INT(events);
@@ -74,6 +93,8 @@ static VALUE rb_czmq_pollitem_s_new(int argc, VALUE *argv, VALUE obj)
     pollitem->item = ALLOC(zmq_pollitem_t);
     ZmqAssertObjOnAlloc(pollitem->item, pollitem);
     pollitem->item->events = evts;
+    pollitem->priority = NIL_P(priority) ? 0 : NUM2INT(priority);
+    pollitem->weight = NIL_P(weight) ? 1 : NUM2INT(weight);
     if (rb_obj_is_kind_of(pollable, rb_cZmqSocket)) {
        GetZmqSocket(pollable);
        ZmqAssertSocketNotPending(sock, "socket in a pending state (not bound or connected) and thus cannot be registered as a poll item!");
@@ -172,6 +193,44 @@ VALUE rb_czmq_pollitem_events(VALUE obj)
     return pollitem->events;
 }
 
+/*
+ *  call-seq:
+ *     pollitem.priority   =>  Fixnum
+ *
+ *  Returns the priority of this poll item. ZMQ::Poller services ready items with lower values first.
+ *
+ * === Examples
+ *
+ *     item = ZMQ::Pollitem.new(sock, ZMQ::POLLIN, priority: 1)   =>  ZMQ::Pollitem
+ *     item.priority                                              =>  1
+ *
+*/
+
+VALUE rb_czmq_pollitem_priority(VALUE obj)
+{
+    ZmqGetPollitem(obj);
+    return INT2NUM(pollitem->priority);
+}
+
+/*
+ *  call-seq:
+ *     pollitem.weight   =>  Fixnum
+ *
+ *  Returns the weight of this poll item - the messages ZMQ::Poller#poll_recv receives from it per round.
+ *
+ * === Examples
+ *
+ *     item = ZMQ::Pollitem.new(sock, ZMQ::POLLIN, weight: 4)   =>  ZMQ::Pollitem
+ *     item.weight                                              =>  4
+ *
+*/
+
+VALUE rb_czmq_pollitem_weight(VALUE obj)
+{
+    ZmqGetPollitem(obj);
+    return INT2NUM(pollitem->weight);
+}
+
 /*
  *  call-seq:
  *     pollitem.handler =>  Object or nil
@@ -247,6 +306,8 @@ void _init_rb_czmq_pollitem()
     rb_define_singleton_method(rb_cZmqPollitem, "coerce", rb_czmq_pollitem_s_coerce, 1);
     rb_define_method(rb_cZmqPollitem, "pollable", rb_czmq_pollitem_pollable, 0);
     rb_define_method(rb_cZmqPollitem, "events", rb_czmq_pollitem_events, 0);
+    rb_define_method(rb_cZmqPollitem, "priority", rb_czmq_pollitem_priority, 0);
+    rb_define_method(rb_cZmqPollitem, "weight", rb_czmq_pollitem_weight, 0);
     rb_define_method(rb_cZmqPollitem, "handler", rb_czmq_pollitem_handler, 0);
     rb_define_method(rb_cZmqPollitem, "handler=", rb_czmq_pollitem_handler_equals, 1);
     rb_define_method(rb_cZmqPollitem, "verbose=", rb_czmq_pollitem_set_verbose, 1);
@@ -7,6 +7,8 @@ typedef struct {
     VALUE events;
     VALUE handler;
     zmq_pollitem_t *item;
+    int priority; /* lower values are serviced first by ZMQ::Poller */
+    int weight; /* messages received per round by ZMQ::Poller#poll_recv, relative to other items of the same priority */
 } zmq_pollitem_wrapper;
 
 #define ZmqAssertPollitem(obj) ZmqAssertType(obj, rb_cZmqPollitem, "ZMQ::Pollitem")
@@ -23,6 +25,8 @@ typedef struct {
 VALUE rb_czmq_pollitem_coerce(VALUE pollable);
 VALUE rb_czmq_pollitem_pollable(VALUE obj);
 VALUE rb_czmq_pollitem_events(VALUE obj);
+VALUE rb_czmq_pollitem_priority(VALUE obj);
+VALUE rb_czmq_pollitem_weight(VALUE obj);
 
 void _init_rb_czmq_pollitem();
 
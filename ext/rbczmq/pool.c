@@ -0,0 +1,184 @@
+#include "rbczmq_ext.h"
+#include <sys/mman.h>
+
+/*
+ * :nodoc:
+ *  Creates a pool, referenced by the caller.
+ *
+*/
+zmq_buffer_pool *rb_czmq_pool_new()
+{
+    int size_class;
+    zmq_buffer_pool *pool = (zmq_buffer_pool *)calloc(1, sizeof(zmq_buffer_pool));
+    if (!pool) rb_memerror();
+    for (size_class = 0; size_class < ZMQ_POOL_CLASSES; size_class++)
+        pthread_mutex_init(&pool->locks[size_class], NULL);
+    pool->max_size = ZMQ_POOL_DEFAULT_MAX_SIZE;
+    pool->enabled = true;
+    pool->refs = 1;
+    return pool;
+}
+
+/*
+ * :nodoc:
+ *  Returns the smallest size class that fits a given size.
+ *
+*/
+static int rb_czmq_pool_size_class(size_t size)
+{
+    int size_class = 0;
+    while (((size_t)ZMQ_POOL_MIN_SIZE << size_class) < size) size_class++;
+    return size_class;
+}
+
+/*
+ * :nodoc:
+ *  Maps a huge page aligned region, advised to be backed by transparent huge pages. Returns NULL if not supported.
+ *
+*/
+static void *rb_czmq_pool_map_huge(size_t size)
+{
+#if defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    char *region = NULL, *aligned = NULL;
+    size_t head;
+    region = (char *)mmap(NULL, size + ZMQ_POOL_HUGE_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == (char *)MAP_FAILED) return NULL;
+    /* trim the over-allocation so the slab starts on a huge page boundary */
+    aligned = (char *)(((uintptr_t)region + ZMQ_POOL_HUGE_SLAB_SIZE - 1) & ~((uintptr_t)ZMQ_POOL_HUGE_SLAB_SIZE - 1));
+    head = (size_t)(aligned - region);
+    if (head) munmap(region, head);
+    if (ZMQ_POOL_HUGE_SLAB_SIZE - head) munmap(aligned + size, ZMQ_POOL_HUGE_SLAB_SIZE - head);
+    madvise(aligned, size, MADV_HUGEPAGE);
+    return aligned;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * :nodoc:
+ *  Allocates a new slab for a size class and links all buffers carved out of it into the free list, except the first
+ *  one which is returned. Requires the size class lock.
+ *
+*/
+static zmq_pool_buffer *rb_czmq_pool_carve(zmq_buffer_pool *pool, int size_class)
+{
+    size_t stride = ZMQ_POOL_HEADER_SIZE + ((size_t)ZMQ_POOL_MIN_SIZE << size_class);
+    size_t size = pool->hugepages ? ZMQ_POOL_HUGE_SLAB_SIZE : ZMQ_POOL_SLAB_SIZE;
+    size_t count, i;
+    zmq_pool_slab *slab = NULL;
+    zmq_pool_buffer *buffer = NULL;
+    char *ptr = NULL;
+    bool mapped = false;
+    while (size < ZMQ_POOL_HEADER_SIZE + stride) size *= 2;
+    if (pool->hugepages) {
+        slab = (zmq_pool_slab *)rb_czmq_pool_map_huge(size);
+        mapped = (slab != NULL);
+    }
+    if (!slab) slab = (zmq_pool_slab *)malloc(size);
+    if (!slab) return NULL;
+    slab->size = size;
+    slab->mapped = mapped;
+    slab->next = pool->slabs[size_class];
+    pool->slabs[size_class] = slab;
+
+    ptr = (char *)slab + ZMQ_POOL_HEADER_SIZE;
+    count = (size - ZMQ_POOL_HEADER_SIZE) / stride;
+    for (i = count; i > 0; i--) {
+        buffer = (zmq_pool_buffer *)(ptr + (i - 1) * stride);
+        buffer->pool = pool;
+        buffer->size_class = size_class;
+        buffer->next = (i > 1) ? pool->free[size_class] : NULL;
+        if (i > 1) pool->free[size_class] = buffer;
+    }
+    return buffer;
+}
+
+/*
+ * :nodoc:
+ *  Returns a buffer of at least the given size, or NULL if the pool is disabled or doesn't serve that size. Release it
+ *  through rb_czmq_pool_free, usually as the libzmq deallocation callback of a zero-copy message. Thread safe and
+ *  may be called without the GVL.
+ *
+*/
+void *rb_czmq_pool_acquire(zmq_buffer_pool *pool, size_t size)
+{
+    zmq_pool_buffer *buffer = NULL;
+    int size_class;
+    if (!pool || !pool->enabled || size < ZMQ_POOL_MIN_SIZE || size > pool->max_size) return NULL;
+    size_class = rb_czmq_pool_size_class(size);
+    pthread_mutex_lock(&pool->locks[size_class]);
+    buffer = pool->free[size_class];
+    if (buffer) {
+        pool->free[size_class] = buffer->next;
+        ZmqAtomicIncrement(pool->hits);
+    } else {
+        buffer = rb_czmq_pool_carve(pool, size_class);
+        ZmqAtomicIncrement(pool->misses);
+    }
+    pthread_mutex_unlock(&pool->locks[size_class]);
+    if (!buffer) return NULL;
+    ZmqAtomicIncrement(pool->refs);
+    ZmqAtomicIncrement(pool->in_use);
+    return (char *)buffer + ZMQ_POOL_HEADER_SIZE;
+}
+
+/*
+ * :nodoc:
+ *  Returns a buffer to its pool. Matches the libzmq deallocation callback signature and may thus be invoked from any
+ *  thread, without the GVL.
+ *
+*/
+void rb_czmq_pool_free(void *data, ZMQ_UNUSED void *hint)
+{
+    zmq_pool_buffer *buffer = (zmq_pool_buffer *)((char *)data - ZMQ_POOL_HEADER_SIZE);
+    zmq_buffer_pool *pool = buffer->pool;
+    pthread_mutex_lock(&pool->locks[buffer->size_class]);
+    buffer->next = pool->free[buffer->size_class];
+    pool->free[buffer->size_class] = buffer;
+    pthread_mutex_unlock(&pool->locks[buffer->size_class]);
+    ZmqAtomicDecrement(pool->in_use);
+    rb_czmq_pool_release(pool);
+}
+
+/*
+ * :nodoc:
+ *  Drops a reference to the pool and frees it, including all slabs, once there are none left.
+ *
+*/
+void rb_czmq_pool_release(zmq_buffer_pool *pool)
+{
+    int size_class;
+    zmq_pool_slab *slab = NULL;
+    if (!pool || ZmqAtomicDecrement(pool->refs) != 0) return;
+    for (size_class = 0; size_class < ZMQ_POOL_CLASSES; size_class++) {
+        while ((slab = pool->slabs[size_class])) {
+            pool->slabs[size_class] = slab->next;
+            if (slab->mapped) {
+                munmap(slab, slab->size);
+            } else {
+                free(slab);
+            }
+        }
+        pthread_mutex_destroy(&pool->locks[size_class]);
+    }
+    free(pool);
+}
+
+/*
+ * :nodoc:
+ *  Returns the number of bytes reserved by all slabs of the pool.
+ *
+*/
+size_t rb_czmq_pool_reserved(zmq_buffer_pool *pool)
+{
+    int size_class;
+    size_t reserved = 0;
+    zmq_pool_slab *slab = NULL;
+    for (size_class = 0; size_class < ZMQ_POOL_CLASSES; size_class++) {
+        pthread_mutex_lock(&pool->locks[size_class]);
+        for (slab = pool->slabs[size_class]; slab; slab = slab->next) reserved += slab->size;
+        pthread_mutex_unlock(&pool->locks[size_class]);
+    }
+    return reserved;
+}
@@ -0,0 +1,59 @@
+#ifndef RBCZMQ_POOL_H
+#define RBCZMQ_POOL_H
+
+#include <pthread.h>
+
+/* Size classes are powers of 2 from 64 bytes to 1MB. Payloads below the smallest class are stored inline in the
+   zmq_msg_t by libzmq and don't need a buffer at all. */
+#define ZMQ_POOL_MIN_SHIFT 6
+#define ZMQ_POOL_MAX_SHIFT 20
+#define ZMQ_POOL_CLASSES (ZMQ_POOL_MAX_SHIFT - ZMQ_POOL_MIN_SHIFT + 1)
+#define ZMQ_POOL_MIN_SIZE (1 << ZMQ_POOL_MIN_SHIFT)
+#define ZMQ_POOL_MAX_SIZE (1 << ZMQ_POOL_MAX_SHIFT)
+#define ZMQ_POOL_DEFAULT_MAX_SIZE 65536
+
+/* Buffers are carved out of slabs, which are only released with the pool. Slabs of hugepage backed pools match the
+   2MB huge page size. */
+#define ZMQ_POOL_SLAB_SIZE (1024 * 1024)
+#define ZMQ_POOL_HUGE_SLAB_SIZE (2 * 1024 * 1024)
+
+/* Every buffer is preceded by a header that links it back to its pool, padded to keep payloads 16 byte aligned */
+#define ZMQ_POOL_HEADER_SIZE 32
+
+struct zmq_buffer_pool;
+
+typedef struct zmq_pool_buffer {
+    struct zmq_buffer_pool *pool;
+    struct zmq_pool_buffer *next;
+    int size_class;
+} zmq_pool_buffer;
+
+typedef struct zmq_pool_slab {
+    struct zmq_pool_slab *next;
+    size_t size;
+    bool mapped;
+} zmq_pool_slab;
+
+/* Buffers are acquired by Ruby threads, possibly without the GVL, and released from libzmq I/O threads, hence plain
+   malloc / mmap and a lock per size class. The pool is reference counted by its context and every buffer in flight,
+   and freed by whoever drops the last reference. */
+typedef struct zmq_buffer_pool {
+    pthread_mutex_t locks[ZMQ_POOL_CLASSES];
+    zmq_pool_buffer *free[ZMQ_POOL_CLASSES];
+    zmq_pool_slab *slabs[ZMQ_POOL_CLASSES];
+    volatile size_t max_size;
+    volatile bool enabled;
+    volatile bool hugepages;
+    volatile unsigned long refs;
+    volatile unsigned long in_use;
+    volatile unsigned long hits;
+    volatile unsigned long misses;
+} zmq_buffer_pool;
+
+zmq_buffer_pool *rb_czmq_pool_new();
+void *rb_czmq_pool_acquire(zmq_buffer_pool *pool, size_t size);
+void rb_czmq_pool_free(void *data, void *hint);
+void rb_czmq_pool_release(zmq_buffer_pool *pool);
+size_t rb_czmq_pool_reserved(zmq_buffer_pool *pool);
+
+#endif
@@ -19,12 +19,15 @@ VALUE rb_cZmqXSubSocket;
 VALUE rb_cZmqStreamSocket;
 
 VALUE rb_cZmqFrame;
+VALUE rb_cZmqFrameBuilder;
 VALUE rb_cZmqMessage;
 VALUE rb_cZmqLoop;
 VALUE rb_cZmqTimer;
 VALUE rb_cZmqPoller;
 VALUE rb_cZmqPollitem;
 VALUE rb_cZmqBeacon;
+VALUE rb_mZmqTrace;
+VALUE rb_cZmqHistogram;
 
 VALUE intern_call;
 VALUE intern_readable;
@@ -33,6 +36,114 @@ VALUE intern_error;
 
 rb_encoding *binary_encoding;
 
+long rb_czmq_zero_copy_threshold = ZMQ_ZERO_COPY_DEFAULT_THRESHOLD;
+long rb_czmq_zero_copy_recv_threshold = -1;
+static zmq_zero_copy_pin *zero_copy_pins = NULL;
+static VALUE zero_copy_pins_marker;
+
+#ifdef ZMQ_ATOMIC_LOCK
+#include <pthread.h>
+static pthread_mutex_t rb_czmq_atomic_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * :nodoc:
+ *  Adds to a counter shared with libzmq I/O threads on compilers without atomic builtins. Returns the new value.
+ *
+*/
+unsigned long rb_czmq_atomic_add(volatile unsigned long *var, long delta)
+{
+    unsigned long value;
+    pthread_mutex_lock(&rb_czmq_atomic_lock);
+    value = (*var += (unsigned long)delta);
+    pthread_mutex_unlock(&rb_czmq_atomic_lock);
+    return value;
+}
+
+/*
+ * :nodoc:
+ *  Full memory barrier on compilers without atomic builtins - taking a lock implies one.
+ *
+*/
+void rb_czmq_memory_barrier()
+{
+    pthread_mutex_lock(&rb_czmq_atomic_lock);
+    pthread_mutex_unlock(&rb_czmq_atomic_lock);
+}
+#endif
+
+/*
+ * :nodoc:
+ *  GC mark callback - keeps the Strings of all pins still referenced alive (and unmoved), and reclaims the pins libzmq
+ *  and Ruby no longer reference, so their Strings can be collected. The marker is not write barrier protected and
+ *  thus marked by minor GCs as well.
+ *
+*/
+static void rb_czmq_mark_zero_copy_pins(ZMQ_UNUSED void *ptr)
+{
+    zmq_zero_copy_pin **link = &zero_copy_pins;
+    zmq_zero_copy_pin *pin;
+    while ((pin = *link)) {
+        if (pin->refs == 0) {
+            *link = pin->next;
+            free(pin);
+        } else {
+            rb_gc_mark(pin->str);
+            link = &pin->next;
+        }
+    }
+}
+
+/*
+ * :nodoc:
+ *  Pins a frozen String for a zero-copy send. The caller owns the initial reference and drops it with
+ *  rb_czmq_zero_copy_unpin once the String has been handed to libzmq. Returns NULL if the String is not eligible.
+ *
+*/
+zmq_zero_copy_pin *rb_czmq_zero_copy_pin(VALUE str)
+{
+    if (!ZmqZeroCopyEligible(str)) return NULL;
+    return rb_czmq_zero_copy_pin_str(str);
+}
+
+/*
+ * :nodoc:
+ *  Pins a frozen String unconditionally, for callers that reference parts of it from several frames. Same reference
+ *  semantics as rb_czmq_zero_copy_pin.
+ *
+*/
+zmq_zero_copy_pin *rb_czmq_zero_copy_pin_str(VALUE str)
+{
+    /* reclaimed while marking, thus not allocated through the GC */
+    zmq_zero_copy_pin *pin = malloc(sizeof(zmq_zero_copy_pin));
+    if (pin == NULL) rb_memerror();
+    pin->str = str;
+    pin->refs = 1;
+    pin->next = zero_copy_pins;
+    zero_copy_pins = pin;
+    return pin;
+}
+
+/*
+ * :nodoc:
+ *  Drops the caller's reference to a pin, if any.
+ *
+*/
+void rb_czmq_zero_copy_unpin(zmq_zero_copy_pin *pin)
+{
+    if (pin) ZmqAtomicDecrement(pin->refs);
+}
+
+/*
+ * :nodoc:
+ *  libzmq deallocation callback for zero-copy messages. May be invoked from any thread, without the GVL.
+ *
+*/
+void rb_czmq_zero_copy_free(ZMQ_UNUSED void *data, void *hint)
+{
+    zmq_zero_copy_pin *pin = (zmq_zero_copy_pin *)hint;
+    ZmqAtomicDecrement(pin->refs);
+}
+
 /*
  *  call-seq:
  *     ZMQ.interrupted?    =>  boolean
@@ -169,6 +280,102 @@ static VALUE rb_czmq_m_interrupted_bang(ZMQ_UNUSED VALUE obj)
     return Qnil;
 }
 
+/*
+ *  call-seq:
+ *     ZMQ.zero_copy_threshold    =>  Fixnum or nil
+ *
+ *  Returns the minimum size in bytes of frozen Strings that are sent or framed without copying, and of frames
+ *  ZMQ::Message.decode references the buffer for, or nil if zero-copy is disabled (the default).
+ *
+ * === Examples
+ *     ZMQ.zero_copy_threshold    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_m_zero_copy_threshold(ZMQ_UNUSED VALUE obj)
+{
+    if (rb_czmq_zero_copy_threshold < 0) return Qnil;
+    return LONG2NUM(rb_czmq_zero_copy_threshold);
+}
+
+/*
+ *  call-seq:
+ *     ZMQ.zero_copy_threshold = 1048576    =>  nil
+ *
+ *  Frozen Strings of at least this many bytes are handed to libzmq as is by ZMQ::Socket#send, ZMQ::Socket#sendm,
+ *  ZMQ::Socket#sendv and ZMQ::Frame.new. Such Strings are kept from being garbage collected until libzmq releases
+ *  them, at least until the next GC after libzmq released them. ZMQ::Message.decode and ZMQ::Message.decode_many
+ *  likewise reference the buffer for frames of at least this many (and 255 or more) bytes instead of copying them.
+ *  Set to nil to always copy (the default).
+ *
+ * === Examples
+ *     ZMQ.zero_copy_threshold = 1048576    =>  nil
+ *     ZMQ.zero_copy_threshold = nil        =>  nil
+ *
+*/
+
+static VALUE rb_czmq_m_set_zero_copy_threshold(ZMQ_UNUSED VALUE obj, VALUE threshold)
+{
+    if (NIL_P(threshold)) {
+        rb_czmq_zero_copy_threshold = -1;
+    } else {
+        Check_Type(threshold, T_FIXNUM);
+        if (FIX2LONG(threshold) < 0) rb_raise(rb_eArgError, "zero-copy threshold must not be negative!");
+        rb_czmq_zero_copy_threshold = FIX2LONG(threshold);
+    }
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ.zero_copy_recv_threshold    =>  Fixnum or nil
+ *
+ *  Returns the minimum size in bytes of received messages that are returned as read-only Strings referencing the
+ *  libzmq message buffer, or nil if received messages are always copied (the default).
+ *
+ * === Examples
+ *     ZMQ.zero_copy_recv_threshold    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_m_zero_copy_recv_threshold(ZMQ_UNUSED VALUE obj)
+{
+    if (rb_czmq_zero_copy_recv_threshold < 0) return Qnil;
+    return LONG2NUM(rb_czmq_zero_copy_recv_threshold);
+}
+
+/*
+ *  call-seq:
+ *     ZMQ.zero_copy_recv_threshold = 1048576    =>  nil
+ *
+ *  Messages of at least this many bytes received through ZMQ::Socket#recv, ZMQ::Socket#recv_nonblock and
+ *  ZMQ::Socket#recv_batch are returned as frozen Strings backed by the libzmq message buffer instead of a copy.
+ *  The buffer is released once the String is garbage collected. Set to nil to always copy (the default). Messages
+ *  smaller than 4096 bytes are always copied.
+ *
+ *  The buffer of such a String is not NUL terminated. Methods that expect a terminated buffer - C extensions using
+ *  StringValueCStr or RSTRING_PTR as a C string, and core conversions such as #to_i and #to_f which look at the byte
+ *  past the end - may read past the message buffer. Use #dup (or String.new) for an independent, terminated copy
+ *  before handing such a String to them.
+ *
+ * === Examples
+ *     ZMQ.zero_copy_recv_threshold = 1048576    =>  nil
+ *     ZMQ.zero_copy_recv_threshold = nil        =>  nil
+ *
+*/
+
+static VALUE rb_czmq_m_set_zero_copy_recv_threshold(ZMQ_UNUSED VALUE obj, VALUE threshold)
+{
+    if (NIL_P(threshold)) {
+        rb_czmq_zero_copy_recv_threshold = -1;
+    } else {
+        Check_Type(threshold, T_FIXNUM);
+        if (FIX2LONG(threshold) < 0) rb_raise(rb_eArgError, "zero-copy threshold must not be negative!");
+        rb_czmq_zero_copy_recv_threshold = FIX2LONG(threshold);
+    }
+    return Qnil;
+}
+
 /*
  * :nodoc:
  *  Runs the ZeroMQ proxy with the GVL released.
@@ -251,6 +458,13 @@ void Init_rbczmq_ext()
     rb_define_module_function(rb_mZmq, "errno", rb_czmq_m_errno, 0);
     rb_define_module_function(rb_mZmq, "interrupted!", rb_czmq_m_interrupted_bang, 0);
     rb_define_module_function(rb_mZmq, "proxy", rb_czmq_m_proxy, -1);
+    rb_define_module_function(rb_mZmq, "zero_copy_threshold", rb_czmq_m_zero_copy_threshold, 0);
+    rb_define_module_function(rb_mZmq, "zero_copy_threshold=", rb_czmq_m_set_zero_copy_threshold, 1);
+    rb_define_module_function(rb_mZmq, "zero_copy_recv_threshold", rb_czmq_m_zero_copy_recv_threshold, 0);
+    rb_define_module_function(rb_mZmq, "zero_copy_recv_threshold=", rb_czmq_m_set_zero_copy_recv_threshold, 1);
+
+    zero_copy_pins_marker = Data_Wrap_Struct(0, rb_czmq_mark_zero_copy_pins, 0, NULL);
+    rb_gc_register_mark_object(zero_copy_pins_marker);
 
     rb_define_const(rb_mZmq, "POLLIN", INT2NUM(ZMQ_POLLIN));
     rb_define_const(rb_mZmq, "POLLOUT", INT2NUM(ZMQ_POLLOUT));
@@ -289,10 +503,14 @@ void Init_rbczmq_ext()
     _init_rb_czmq_context();
     _init_rb_czmq_socket();
     _init_rb_czmq_frame();
+    _init_rb_czmq_frame_builder();
+    _init_rb_czmq_frame_numeric();
     _init_rb_czmq_message();
     _init_rb_czmq_timer();
     _init_rb_czmq_loop();
     _init_rb_czmq_poller();
     _init_rb_czmq_pollitem();
     _init_rb_czmq_beacon();
+    _init_rb_czmq_trace();
+    _init_rb_czmq_histogram();
 }
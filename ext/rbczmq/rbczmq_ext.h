@@ -14,10 +14,42 @@
 #define ZMQ_NOINLINE
 #endif
 
+/* Atomic updates of volatile unsigned long counters - zero-copy pins, buffer pools and trace buffers are updated from
+   libzmq I/O threads. Both increment and decrement return the new value. */
+#if defined(__GNUC__) && (__GNUC__ >= 3)
+#define ZmqAtomicIncrement(var) __sync_add_and_fetch(&(var), 1)
+#define ZmqAtomicDecrement(var) __sync_sub_and_fetch(&(var), 1)
+#define ZmqMemoryBarrier() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <windows.h>
+#define ZmqAtomicIncrement(var) ((unsigned long)InterlockedIncrement((volatile LONG *)&(var)))
+#define ZmqAtomicDecrement(var) ((unsigned long)InterlockedDecrement((volatile LONG *)&(var)))
+#define ZmqMemoryBarrier() MemoryBarrier()
+#elif defined(__SUNPRO_C)
+#include <atomic.h>
+#define ZmqAtomicIncrement(var) atomic_inc_ulong_nv((volatile ulong_t *)&(var))
+#define ZmqAtomicDecrement(var) atomic_dec_ulong_nv((volatile ulong_t *)&(var))
+#define ZmqMemoryBarrier() \
+  do { \
+      membar_enter(); \
+      membar_exit(); \
+  } while(0)
+#else
+/* serialized through a lock - see rbczmq_ext.c */
+#define ZMQ_ATOMIC_LOCK
+unsigned long rb_czmq_atomic_add(volatile unsigned long *var, long delta);
+void rb_czmq_memory_barrier();
+#define ZmqAtomicIncrement(var) rb_czmq_atomic_add(&(var), 1)
+#define ZmqAtomicDecrement(var) rb_czmq_atomic_add(&(var), -1)
+#define ZmqMemoryBarrier() rb_czmq_memory_barrier()
+#endif
+
 #include "rbczmq_prelude.h"
 
 #include <ruby/encoding.h>
 #include <ruby/io.h>
+#include <stdint.h>
+#include <time.h>
 extern rb_encoding *binary_encoding;
 #define ZmqEncode(str) rb_enc_associate(str, binary_encoding)
 
@@ -69,27 +101,60 @@ extern VALUE rb_cZmqXSubSocket;
 extern VALUE rb_cZmqStreamSocket;
 
 extern VALUE rb_cZmqFrame;
+extern VALUE rb_cZmqFrameBuilder;
 extern VALUE rb_cZmqMessage;
 extern VALUE rb_cZmqLoop;
 extern VALUE rb_cZmqTimer;
 extern VALUE rb_cZmqPoller;
 extern VALUE rb_cZmqPollitem;
 extern VALUE rb_cZmqBeacon;
+extern VALUE rb_mZmqTrace;
+extern VALUE rb_cZmqHistogram;
 
 extern VALUE intern_call;
 extern VALUE intern_readable;
 extern VALUE intern_writable;
 extern VALUE intern_error;
 
+/* A frozen Ruby String handed to libzmq without copying. The String is marked by the GC for as long as either the
+   Ruby call that pinned it or a zmq_msg_t referencing its buffer holds a reference. libzmq drops message references
+   from its I/O threads, thus references are counted atomically and released pins reclaimed by the GC, which stops
+   marking their Strings. */
+typedef struct zmq_zero_copy_pin {
+    VALUE str;
+    volatile unsigned long refs;
+    struct zmq_zero_copy_pin *next;
+} zmq_zero_copy_pin;
+
+/* Zero-copy sends are opt-in */
+#define ZMQ_ZERO_COPY_DEFAULT_THRESHOLD -1
+
+extern long rb_czmq_zero_copy_threshold;
+extern long rb_czmq_zero_copy_recv_threshold;
+
+#define ZmqZeroCopyEligible(str) \
+    (rb_czmq_zero_copy_threshold >= 0 && OBJ_FROZEN(str) && RSTRING_LEN(str) > 0 && RSTRING_LEN(str) >= rb_czmq_zero_copy_threshold)
+
+zmq_zero_copy_pin *rb_czmq_zero_copy_pin(VALUE str);
+zmq_zero_copy_pin *rb_czmq_zero_copy_pin_str(VALUE str);
+void rb_czmq_zero_copy_unpin(zmq_zero_copy_pin *pin);
+void rb_czmq_zero_copy_free(void *data, void *hint);
+
+#include "histogram.h"
+#include "pool.h"
+#include "compression.h"
 #include "context.h"
 #include "socket.h"
 #include "frame.h"
+#include "frame_builder.h"
+#include "msgpack.h"
 #include "message.h"
 #include "loop.h"
 #include "timer.h"
-#include "poller.h"
 #include "pollitem.h"
+#include "poller.h"
 #include "beacon.h"
+#include "trace.h"
 
 static inline char *rb_czmq_formatted_current_time()
 {
@@ -101,4 +166,41 @@ static inline char *rb_czmq_formatted_current_time()
     return formatted;
 }
 
+/* MurmurHash64A - fast, non-cryptographic hash of a buffer, chainable through the seed. Backs ZMQ::Frame#hash and
+   ZMQ::Message#hash. */
+#define ZMQ_HASH_M 0xc6a4a7935bd1e995ULL
+#define ZMQ_HASH_R 47
+
+static inline uint64_t rb_czmq_hash(const void *data, size_t len, uint64_t seed)
+{
+    const unsigned char *ptr = (const unsigned char *)data;
+    const unsigned char *end = ptr + (len & ~(size_t)7);
+    uint64_t h = seed ^ ((uint64_t)len * ZMQ_HASH_M);
+    uint64_t k;
+    for (; ptr != end; ptr += 8) {
+        memcpy(&k, ptr, 8);
+        k *= ZMQ_HASH_M;
+        k ^= k >> ZMQ_HASH_R;
+        k *= ZMQ_HASH_M;
+        h ^= k;
+        h *= ZMQ_HASH_M;
+    }
+    switch (len & 7) {
+        case 7: h ^= (uint64_t)ptr[6] << 48;
+        case 6: h ^= (uint64_t)ptr[5] << 40;
+        case 5: h ^= (uint64_t)ptr[4] << 32;
+        case 4: h ^= (uint64_t)ptr[3] << 24;
+        case 3: h ^= (uint64_t)ptr[2] << 16;
+        case 2: h ^= (uint64_t)ptr[1] << 8;
+        case 1: h ^= (uint64_t)ptr[0];
+                h *= ZMQ_HASH_M;
+    }
+    h ^= h >> ZMQ_HASH_R;
+    h *= ZMQ_HASH_M;
+    h ^= h >> ZMQ_HASH_R;
+    return h;
+}
+
+#define ZmqHash2Fix(h) LONG2FIX((long)((h) & (uint64_t)FIXNUM_MAX))
+
 #endif
@@ -10,4 +10,11 @@
   rb_thread_blocking_region((rb_blocking_function_t *)func, data1, ubf, data2)
 #endif
 
+/* Interrupts raise as soon as the GVL is reacquired without rb_thread_call_without_gvl2, even if messages have been
+   received while it was released */
+#ifndef HAVE_RB_THREAD_CALL_WITHOUT_GVL2
+#define rb_thread_call_without_gvl2(func, data1, ubf, data2) \
+  rb_thread_call_without_gvl(func, data1, ubf, data2)
+#endif
+
 #endif
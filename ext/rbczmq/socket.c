@@ -11,6 +11,8 @@ VALUE intern_on_closed;
 VALUE intern_on_close_failed;
 VALUE intern_on_disconnected;
 
+static VALUE intern_zmq_msg;
+
 /*
  * :nodoc:
  *  GC mark callback
@@ -61,6 +63,9 @@ void rb_czmq_free_sock_gc(void *ptr)
 */
 
         rb_czmq_context_destroy_socket(sock);
+        if (sock->registrations) rb_czmq_poller_socket_freed(sock);
+        if (sock->latency[ZMQ_LATENCY_SEND]) xfree(sock->latency[ZMQ_LATENCY_SEND]);
+        if (sock->latency[ZMQ_LATENCY_RECV]) xfree(sock->latency[ZMQ_LATENCY_RECV]);
         xfree(sock);
     }
 }
@@ -208,6 +213,7 @@ static VALUE rb_czmq_socket_bind(VALUE obj, VALUE endpoint)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     Check_Type(endpoint, T_STRING);
     args.socket = sock;
     args.endpoint = StringValueCStr(endpoint);
@@ -249,6 +255,7 @@ static VALUE rb_czmq_socket_connect(VALUE obj, VALUE endpoint)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     Check_Type(endpoint, T_STRING);
     args.socket = sock;
     args.endpoint = StringValueCStr(endpoint);
@@ -303,6 +310,7 @@ static VALUE rb_czmq_socket_disconnect(VALUE obj, VALUE endpoint)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     Check_Type(endpoint, T_STRING);
     args.socket = sock;
     args.endpoint = StringValueCStr(endpoint);
@@ -357,6 +365,7 @@ static VALUE rb_czmq_socket_unbind(VALUE obj, VALUE endpoint)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     Check_Type(endpoint, T_STRING);
     args.socket = sock;
     args.endpoint = StringValueCStr(endpoint);
@@ -377,7 +386,8 @@ static VALUE rb_czmq_socket_unbind(VALUE obj, VALUE endpoint)
  *  call-seq:
  *     sock.verbose = true   =>  nil
  *
- *  Let this socket be verbose - dumps a lot of data to stdout for debugging.
+ *  Let this socket be verbose - dumps a lot of data to stdout for debugging. Copies and formats every frame sent or
+ *  received, see ZMQ::Trace for a low overhead alternative.
  *
  * === Examples
  *     ctx = ZMQ::Context.new
@@ -396,22 +406,297 @@ static VALUE rb_czmq_socket_set_verbose(VALUE obj, VALUE level)
     return Qnil;
 }
 
+/*
+ *  call-seq:
+ *     sock.fast_path = false   =>  nil
+ *
+ *  Toggles the non-blocking fast path for send, sendm, recv, recv_frame and recv_message. When enabled (the default),
+ *  these first attempt the operation without releasing the GVL and only fall back to a blocking call with the GVL
+ *  released if the operation would block. See ZMQ::Socket#compression= for when compressing sockets skip it.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.fast_path = false    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_socket_set_fast_path(VALUE obj, VALUE enabled)
+{
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    CheckBoolean(enabled);
+    sock->fast_path = (enabled == Qtrue) ? true : false;
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     sock.fast_path?   =>  boolean
+ *
+ *  Determines if sends and receives attempt the operation without releasing the GVL first.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.fast_path?    =>  true
+ *
+*/
+
+static VALUE rb_czmq_socket_fast_path_p(VALUE obj)
+{
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    return (sock->fast_path == true) ? Qtrue : Qfalse;
+}
+
+/*
+ *  call-seq:
+ *     sock.compression = true    =>  nil
+ *     sock.compression = {codec: :zlib, level: 1, min_size: 1024}    =>  nil
+ *     sock.compression = nil    =>  nil
+ *
+ *  Enables or disables payload compression for all sends and receives on this socket. Every frame sent is prefixed
+ *  with a 4 byte header, and frames of at least :min_size bytes (default 1024) are deflated with :codec (only :zlib is
+ *  supported) at :level (0 - 9, default 1) unless that doesn't make them any smaller. Deflating and inflating happens
+ *  with the GVL released - blocking sends of such frames and all blocking receives skip the fast path for that. The
+ *  non-blocking variants do it inline. There is no handshake: both peers have to enable compression, and receiving a
+ *  frame without a known header raises ZMQ::Error. Raises NotImplementedError if built without zlib.
+ *
+ *  As every frame is compressed, subscription topics and routing envelopes would be too : raises ArgumentError for
+ *  PUB, XPUB, SUB, XSUB, ROUTER and STREAM sockets. For the same reason, DEALER sockets talking to REP or ROUTER
+ *  peers can't use compression.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PUSH)
+ *     sock.compression = {codec: :zlib, level: 1, min_size: 1024}    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_socket_set_compression(VALUE obj, VALUE options)
+{
+    VALUE codec = Qnil, level = Qnil, min_size = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqSockGuardCrossThread(sock);
+    if (NIL_P(options) || options == Qfalse) {
+        sock->compression.codec = ZMQ_COMPRESSION_NONE;
+        return Qnil;
+    }
+    switch (zsocket_type(sock->socket)) {
+        case ZMQ_PUB:
+        case ZMQ_XPUB:
+        case ZMQ_SUB:
+        case ZMQ_XSUB:
+        case ZMQ_ROUTER:
+        case ZMQ_STREAM:
+            rb_raise(rb_eArgError, "compression is not supported on %s sockets, it would hide topics and envelopes!", zsocket_type_str(sock->socket));
+    }
+#ifndef HAVE_LIBZ
+    rb_raise(rb_eNotImpError, "compression is not supported, rbczmq was built without zlib!");
+#endif
+    if (options != Qtrue) {
+        Check_Type(options, T_HASH);
+        codec = rb_hash_aref(options, ID2SYM(rb_intern("codec")));
+        level = rb_hash_aref(options, ID2SYM(rb_intern("level")));
+        min_size = rb_hash_aref(options, ID2SYM(rb_intern("min_size")));
+    }
+    if (!NIL_P(codec) && codec != ID2SYM(rb_intern("zlib")))
+        rb_raise(rb_eArgError, "unsupported compression codec, expected :zlib!");
+    if (!NIL_P(level)) {
+        Check_Type(level, T_FIXNUM);
+        if (FIX2LONG(level) < 0 || FIX2LONG(level) > 9) rb_raise(rb_eArgError, "compression level must be between 0 and 9!");
+    }
+    if (!NIL_P(min_size)) {
+        Check_Type(min_size, T_FIXNUM);
+        if (FIX2LONG(min_size) < 0) rb_raise(rb_eArgError, "compression min_size must not be negative!");
+    }
+    sock->compression.level = NIL_P(level) ? ZMQ_COMPRESSION_DEFAULT_LEVEL : FIX2INT(level);
+    sock->compression.min_size = NIL_P(min_size) ? ZMQ_COMPRESSION_DEFAULT_MIN_SIZE : (size_t)FIX2LONG(min_size);
+    sock->compression.codec = ZMQ_COMPRESSION_ZLIB;
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     sock.compression    =>  Hash or nil
+ *
+ *  Returns the compression settings of this socket, or nil if compression is not enabled.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PUSH)
+ *     sock.compression = true
+ *     sock.compression    =>  {:codec=>:zlib, :level=>1, :min_size=>1024}
+ *
+*/
+
+static VALUE rb_czmq_socket_compression(VALUE obj)
+{
+    VALUE settings;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    if (!ZmqCompressing(&sock->compression)) return Qnil;
+    settings = rb_hash_new();
+    rb_hash_aset(settings, ID2SYM(rb_intern("codec")), ID2SYM(rb_intern("zlib")));
+    rb_hash_aset(settings, ID2SYM(rb_intern("level")), INT2FIX(sock->compression.level));
+    rb_hash_aset(settings, ID2SYM(rb_intern("min_size")), ULONG2NUM((unsigned long)sock->compression.min_size));
+    return rb_obj_freeze(settings);
+}
+
+/*
+ *  call-seq:
+ *     sock.stats   =>  Hash
+ *
+ *  Returns a frozen snapshot of this socket's I/O counters : messages and bytes sent and received (every part of a
+ *  multipart message counts as a message), failed operations due to EAGAIN and EINTR, the number of times the GVL was
+ *  released for a blocking send or receive and the cumulative nanoseconds spent blocked in those.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.stats    =>  {:messages_sent=>0, :bytes_sent=>0, :messages_received=>0, ... }
+ *
+*/
+
+static VALUE rb_czmq_socket_stats(VALUE obj)
+{
+    VALUE stats;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("messages_sent")), ULL2NUM(sock->stats.messages_sent));
+    rb_hash_aset(stats, ID2SYM(rb_intern("bytes_sent")), ULL2NUM(sock->stats.bytes_sent));
+    rb_hash_aset(stats, ID2SYM(rb_intern("messages_received")), ULL2NUM(sock->stats.messages_received));
+    rb_hash_aset(stats, ID2SYM(rb_intern("bytes_received")), ULL2NUM(sock->stats.bytes_received));
+    rb_hash_aset(stats, ID2SYM(rb_intern("eagain")), ULL2NUM(sock->stats.eagain));
+    rb_hash_aset(stats, ID2SYM(rb_intern("eintr")), ULL2NUM(sock->stats.eintr));
+    rb_hash_aset(stats, ID2SYM(rb_intern("gvl_releases")), ULL2NUM(sock->stats.gvl_releases));
+    rb_hash_aset(stats, ID2SYM(rb_intern("blocked_ns")), ULL2NUM(sock->stats.blocked_ns));
+    return rb_obj_freeze(stats);
+}
+
+/*
+ *  call-seq:
+ *     sock.reset_stats   =>  nil
+ *
+ *  Resets all I/O counters and latency histograms of this socket.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.reset_stats    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_socket_reset_stats(VALUE obj)
+{
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    MEMZERO(&sock->stats, zmq_sock_stats, 1);
+    if (sock->latency[ZMQ_LATENCY_SEND]) MEMZERO(sock->latency[ZMQ_LATENCY_SEND], zmq_histogram, 1);
+    if (sock->latency[ZMQ_LATENCY_RECV]) MEMZERO(sock->latency[ZMQ_LATENCY_RECV], zmq_histogram, 1);
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     sock.send_latency   =>  ZMQ::Histogram
+ *
+ *  Returns a snapshot of the histogram of nanoseconds this socket spent blocked in sends with the GVL released.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REQ)
+ *     sock.send_latency.percentile(99)    =>  12543
+ *
+*/
+
+static VALUE rb_czmq_socket_send_latency(VALUE obj)
+{
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    return rb_czmq_histogram_snapshot(sock->latency[ZMQ_LATENCY_SEND]);
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_latency   =>  ZMQ::Histogram
+ *
+ *  Returns a snapshot of the histogram of nanoseconds this socket spent blocked in receives with the GVL released.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.recv_latency.p999    =>  1045503
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_latency(VALUE obj)
+{
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    return rb_czmq_histogram_snapshot(sock->latency[ZMQ_LATENCY_RECV]);
+}
+
+/*
+ * :nodoc:
+ *  Runs a blocking send or receive on this socket with the GVL released, accounting for the time spent blocked in
+ *  the counters and the latency histogram for the given direction. Pending interrupts are left to the caller if
+ *  defer_ints is set.
+ *
+*/
+VALUE rb_czmq_socket_call_without_gvl(zmq_sock_wrapper *sock, int direction, void *(*func)(void *), void *args, bool defer_ints)
+{
+    uint64_t blocked, start = rb_czmq_monotonic_clock();
+    VALUE result;
+    if (defer_ints) {
+        result = (VALUE)rb_thread_call_without_gvl2(func, args, RUBY_UBF_IO, 0);
+    } else {
+        result = (VALUE)rb_thread_call_without_gvl(func, args, RUBY_UBF_IO, 0);
+    }
+    blocked = rb_czmq_monotonic_clock() - start;
+    sock->stats.gvl_releases++;
+    sock->stats.blocked_ns += blocked;
+    if (sock->latency[direction] == NULL) {
+        sock->latency[direction] = ALLOC(zmq_histogram);
+        MEMZERO(sock->latency[direction], zmq_histogram, 1);
+    }
+    rb_czmq_histogram_record(sock->latency[direction], blocked);
+    return result;
+}
+
 /*
  * :nodoc:
  *
  * Based on czmq `s_send_string` to send a C string. We need to be able to support
  * strings that contain null bytes, so we cannot use zstr_send as it is intended for
- * null terminated C strings.
+ * null terminated C strings. Pinned strings are referenced by the message instead of copied, others are copied into
+ * a buffer from the context's buffer pool, if enabled. Compressing sockets always copy into a framed message.
  */
 static int rb_czmq_nogvl_zstr_send_internal(struct nogvl_send_args *args, int flags)
 {
     errno = 0;
     zmq_sock_wrapper *socket = args->socket;
+    zmq_buffer_pool *pool = socket->ctx_wrapper ? ((zmq_ctx_wrapper *)socket->ctx_wrapper)->pool : NULL;
+    void *buffer = NULL;
 
     zmq_msg_t message;
-    zmq_msg_init_size(&message, args->length);
-    memcpy(zmq_msg_data(&message), args->msg, args->length);
+    if (ZmqCompressing(&socket->compression)) {
+        if (rb_czmq_compress_msg(&socket->compression, args->msg, (size_t)args->length, &message) == -1) return -1;
+    } else if (args->pin) {
+        ZmqAtomicIncrement(args->pin->refs);
+        zmq_msg_init_data(&message, (void *)args->msg, args->length, rb_czmq_zero_copy_free, args->pin);
+    } else if ((buffer = rb_czmq_pool_acquire(pool, (size_t)args->length))) {
+        memcpy(buffer, args->msg, args->length);
+        zmq_msg_init_data(&message, buffer, args->length, rb_czmq_pool_free, NULL);
+    } else {
+        zmq_msg_init_size(&message, args->length);
+        memcpy(zmq_msg_data(&message), args->msg, args->length);
+    }
     int rc = zmq_sendmsg(socket->socket, &message, flags);
+    if (rc == -1) zmq_msg_close(&message);
     return (rc == -1? -1: 0);
 }
 
@@ -420,12 +705,12 @@ static int rb_czmq_nogvl_zstr_send_internal(struct nogvl_send_args *args, int fl
  *  Sends a raw string while the GIL is released.
  *
 */
-static VALUE rb_czmq_nogvl_zstr_send(void *ptr)
+static void *rb_czmq_nogvl_zstr_send(void *ptr)
 {
     struct nogvl_send_args *args = ptr;
     errno = 0;
     int rc = rb_czmq_nogvl_zstr_send_internal(args, 0);
-    return (VALUE)rc;
+    return (void *)(intptr_t)rc;
 }
 
 /*
@@ -433,12 +718,12 @@ static VALUE rb_czmq_nogvl_zstr_send(void *ptr)
  *  Sends a raw string with the multi flag set while the GIL is released.
  *
 */
-static VALUE rb_czmq_nogvl_zstr_sendm(void *ptr)
+static void *rb_czmq_nogvl_zstr_sendm(void *ptr)
 {
     struct nogvl_send_args *args = ptr;
     errno = 0;
     int rc = rb_czmq_nogvl_zstr_send_internal(args, ZMQ_SNDMORE);
-    return (VALUE)rc;
+    return (void *)(intptr_t)rc;
 }
 
 /*
@@ -458,18 +743,28 @@ static VALUE rb_czmq_nogvl_zstr_sendm(void *ptr)
 static VALUE rb_czmq_socket_send(VALUE obj, VALUE msg)
 {
     int rc;
+    bool fast;
     struct nogvl_send_args args;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
     StringValue(msg);
     Check_Type(msg, T_STRING);
     args.msg = RSTRING_PTR(msg);
     args.length = RSTRING_LEN(msg);
-    rc = (int)rb_thread_call_without_gvl(rb_czmq_nogvl_zstr_send, (void *)&args, RUBY_UBF_IO, 0);
+    args.pin = rb_czmq_zero_copy_pin(msg);
+    fast = ZmqSendFastPath(sock, args.length);
+    rc = fast ? rb_czmq_nogvl_zstr_send_internal(&args, ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_zstr_send, &args);
+    rb_czmq_zero_copy_unpin(args.pin);
+    if (rc == -1) ZmqStatsError(sock);
     ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, args.length);
+    ZmqTrace(sock, ZMQ_TRACE_SEND, args.msg, args.length);
     if (sock->verbose)
         zclock_log ("I: %s socket %p: send \"%s\"", zsocket_type_str(sock->socket), obj, StringValueCStr(msg));
     return Qtrue;
@@ -493,173 +788,970 @@ static VALUE rb_czmq_socket_send(VALUE obj, VALUE msg)
 static VALUE rb_czmq_socket_sendm(VALUE obj, VALUE msg)
 {
     int rc;
+    bool fast;
     struct nogvl_send_args args;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
     StringValue(msg);
     Check_Type(msg, T_STRING);
     args.msg = RSTRING_PTR(msg);
     args.length = RSTRING_LEN(msg);
-    rc = (int)rb_thread_call_without_gvl(rb_czmq_nogvl_zstr_sendm, (void *)&args, RUBY_UBF_IO, 0);
+    args.pin = rb_czmq_zero_copy_pin(msg);
+    fast = ZmqSendFastPath(sock, args.length);
+    rc = fast ? rb_czmq_nogvl_zstr_send_internal(&args, ZMQ_SNDMORE | ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_zstr_sendm, &args);
+    rb_czmq_zero_copy_unpin(args.pin);
+    if (rc == -1) ZmqStatsError(sock);
     ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, args.length);
+    ZmqTrace(sock, ZMQ_TRACE_SENDM, args.msg, args.length);
     if (sock->verbose)
         zclock_log ("I: %s socket %p: sendm \"%s\"", zsocket_type_str(sock->socket), sock->socket, StringValueCStr(msg));
     return Qtrue;
 }
 
-/*
- * :nodoc:
- *  Receives a raw string while the GIL is released.
- *
-*/
-static VALUE rb_czmq_nogvl_recv(void *ptr)
-{
-    struct nogvl_recv_args *args = ptr;
-    errno = 0;
-    zmq_sock_wrapper *socket = args->socket;
-
-    // implement similar to zstr_recv, except that the copy to the string is done
-    // after we return with the GIL so that the ruby string object can be created
-    // from the zmq message buffer in a single copy.
-    assert (socket->socket);
-    int rc = zmq_recvmsg(socket->socket, &args->message, 0);
-    return (VALUE)rc;
-}
-
 /*
  *  call-seq:
- *     sock.recv =>  String or nil
+ *     sock.send_nonblock("message")  =>  boolean
  *
- *  Receive a string from this ZMQ socket. May block depending on the socket type.
+ *  Sends a string to this ZMQ socket without blocking and without releasing the GIL. Returns false if the message could
+ *  not be queued right away, for example when the high water mark has been reached.
  *
  * === Examples
  *     ctx = ZMQ::Context.new
- *     sock = ctx.socket(:REP)
- *     sock.bind("inproc://test")
- *     sock.recv    =>  "message"
+ *     sock = ctx.socket(:PUSH)
+ *     sock.connect("inproc://test")
+ *     sock.send_nonblock("message")    =>  true
  *
 */
 
-static VALUE rb_czmq_socket_recv(VALUE obj)
+static VALUE rb_czmq_socket_send_nonblock(VALUE obj, VALUE msg)
 {
-    char *str = NULL;
-    struct nogvl_recv_args args;
-    VALUE result = Qnil;
+    int rc;
+    struct nogvl_send_args args;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
-    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
-    zmq_msg_init(&args.message);
-
-    int rc = (int)rb_thread_call_without_gvl(rb_czmq_nogvl_recv, (void *)&args, RUBY_UBF_IO, 0);
-    if (rc < 0) {
-        zmq_msg_close(&args.message);
-        return Qnil;
-    }
-    ZmqAssertSysError();
+    StringValue(msg);
+    Check_Type(msg, T_STRING);
+    args.msg = RSTRING_PTR(msg);
+    args.length = RSTRING_LEN(msg);
+    args.pin = rb_czmq_zero_copy_pin(msg);
+    rc = rb_czmq_nogvl_zstr_send_internal(&args, ZMQ_DONTWAIT);
+    rb_czmq_zero_copy_unpin(args.pin);
+    if (rc == -1) ZmqStatsError(sock);
+    if (rc == -1 && zmq_errno() == EAGAIN) return Qfalse;
+    ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, args.length);
+    ZmqTrace(sock, ZMQ_TRACE_SEND, args.msg, args.length);
     if (sock->verbose)
-        zclock_log ("I: %s socket %p: recv \"%s\"", zsocket_type_str(sock->socket), sock->socket, str);
-
-    result = rb_str_new(zmq_msg_data(&args.message), zmq_msg_size(&args.message));
-    zmq_msg_close(&args.message);
-
-    result = ZmqEncode(result);
-    return result;
+        zclock_log ("I: %s socket %p: send_nonblock \"%s\"", zsocket_type_str(sock->socket), sock->socket, StringValueCStr(msg));
+    return Qtrue;
 }
 
 /*
  *  call-seq:
- *     sock.recv_nonblock =>  String or nil
+ *     sock.sendm_nonblock("message")  =>  boolean
  *
- *  Receive a string from this ZMQ socket. Does not block.
+ *  Sends a string to this ZMQ socket, with a more flag set, without blocking and without releasing the GIL. Returns
+ *  false if the part could not be queued right away.
  *
  * === Examples
  *     ctx = ZMQ::Context.new
- *     sock = ctx.socket(:REP)
- *     sock.bind("inproc://test")
- *     sock.recv_nonblock    =>  "message"
+ *     sock = ctx.socket(:PUSH)
+ *     sock.connect("inproc://test")
+ *     sock.sendm_nonblock("mes")    =>  true
+ *     sock.send_nonblock("sage")    =>  true
  *
 */
 
-static VALUE rb_czmq_socket_recv_nonblock(VALUE obj)
+static VALUE rb_czmq_socket_sendm_nonblock(VALUE obj, VALUE msg)
 {
-    struct nogvl_recv_args args;
-    errno = 0;
-    VALUE result = Qnil;
+    int rc;
+    struct nogvl_send_args args;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
-    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
-
-    zmq_msg_init(&args.message);
-
-    int rc = zmq_recvmsg(sock->socket, &args.message, ZMQ_DONTWAIT);
-    if (rc < 0) {
-        zmq_msg_close(&args.message);
-        return Qnil;
-    }
-    ZmqAssertSysError();
-
-    result = rb_str_new(zmq_msg_data(&args.message), zmq_msg_size(&args.message));
-    zmq_msg_close(&args.message);
-
-    if (sock->verbose) {
-        zclock_log ("I: %s socket %p: recv \"%s\"", zsocket_type_str(sock->socket), sock->socket, StringValueCStr(result));
-    }
-
-    result = ZmqEncode(result);
-    return result;
+    ZmqSocketTouched(sock);
+    args.socket = sock;
+    StringValue(msg);
+    Check_Type(msg, T_STRING);
+    args.msg = RSTRING_PTR(msg);
+    args.length = RSTRING_LEN(msg);
+    args.pin = rb_czmq_zero_copy_pin(msg);
+    rc = rb_czmq_nogvl_zstr_send_internal(&args, ZMQ_SNDMORE | ZMQ_DONTWAIT);
+    rb_czmq_zero_copy_unpin(args.pin);
+    if (rc == -1) ZmqStatsError(sock);
+    if (rc == -1 && zmq_errno() == EAGAIN) return Qfalse;
+    ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, args.length);
+    ZmqTrace(sock, ZMQ_TRACE_SENDM, args.msg, args.length);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: sendm_nonblock \"%s\"", zsocket_type_str(sock->socket), sock->socket, StringValueCStr(msg));
+    return Qtrue;
 }
 
 /*
  * :nodoc:
- *  Sends a frame while the GIL is released.
+ *  Sends all parts of a multipart message while the GIL is released. Every part but the last has the more flag set.
  *
 */
-static VALUE rb_czmq_nogvl_send_frame(void *ptr)
+static void *rb_czmq_nogvl_sendv(void *ptr)
 {
-    struct nogvl_send_frame_args *args = ptr;
+    struct nogvl_sendv_args *args = ptr;
+    long i;
     errno = 0;
-    zmq_sock_wrapper *socket = args->socket;
-    return (VALUE)zframe_send(&(args->frame), socket->socket, args->flags);
+    for (i = 0; i < args->count; i++) {
+        if (rb_czmq_nogvl_zstr_send_internal(&args->parts[i], (i < args->count - 1) ? ZMQ_SNDMORE : 0) == -1) return (void *)(intptr_t)-1;
+    }
+    return (void *)(intptr_t)0;
 }
 
 /*
  *  call-seq:
- *     sock.send_frame(frame) =>  nil
+ *     sock.sendv(["topic", "payload"])  =>  boolean
  *
- *  Sends a ZMQ::Frame instance to this socket.
+ *  Sends an Array of Strings and / or ZMQ::Frame instances to this ZMQ socket as a single multipart message. All parts
+ *  are sent with a single GVL release. Frames are copied and remain owned by the caller.
  *
  * === Examples
  *     ctx = ZMQ::Context.new
- *     sock = ctx.socket(:REP)
+ *     sock = ctx.socket(:PUB)
  *     sock.bind("inproc://test")
- *     frame = ZMQ::Frame("frame")
- *     sock.send_frame(frame)    =>  nil
- *     frame = ZMQ::Frame("multi")
- *     sock.send_frame(frame, ZMQ::Frame::MORE)
+ *     sock.sendv(["topic", ZMQ::Frame("payload")])    =>  true
  *
 */
 
-static VALUE rb_czmq_socket_send_frame(int argc, VALUE *argv, VALUE obj)
+static VALUE rb_czmq_socket_sendv(VALUE obj, VALUE parts)
 {
-    struct nogvl_send_frame_args args;
-    VALUE frame_obj;
-    VALUE flags;
-    char print_prefix[255];
-    char *cur_time = NULL;
-    zframe_t *print_frame = NULL;
-    int rc, flgs;
+    int rc;
+    long i, count;
+    VALUE part;
+    struct nogvl_sendv_args args;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
-    rb_scan_args(argc, argv, "11", &frame_obj, &flags);
-    ZmqGetFrame(frame_obj);
+    ZmqSocketTouched(sock);
+    Check_Type(parts, T_ARRAY);
+    count = RARRAY_LEN(parts);
+    if (count == 0) rb_raise(rb_eArgError, "cannot send a multipart message without any parts!");
+    /* validate all parts before allocating, as type errors raise */
+    for (i = 0; i < count; i++) {
+        part = rb_ary_entry(parts, i);
+        if (rb_obj_is_kind_of(part, rb_cZmqFrame)) {
+            ZmqGetFrame(part);
+            ZmqAssertFrameOwned(frame);
+        } else {
+            Check_Type(part, T_STRING);
+        }
+    }
+    args.socket = sock;
+    args.count = count;
+    args.parts = ALLOC_N(struct nogvl_send_args, count);
+    for (i = 0; i < count; i++) {
+        part = rb_ary_entry(parts, i);
+        args.parts[i].socket = sock;
+        if (TYPE(part) == T_STRING) {
+            args.parts[i].msg = RSTRING_PTR(part);
+            args.parts[i].length = RSTRING_LEN(part);
+            args.parts[i].pin = rb_czmq_zero_copy_pin(part);
+        } else {
+            ZmqGetFrame(part);
+            args.parts[i].msg = (const char *)zframe_data(frame->frame);
+            args.parts[i].length = (long)zframe_size(frame->frame);
+            args.parts[i].pin = NULL;
+        }
+    }
+    rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_sendv, &args);
+    if (rc == -1) ZmqStatsError(sock);
+    for (i = 0; i < count; i++) {
+        rb_czmq_zero_copy_unpin(args.parts[i].pin);
+        if (rc == 0) {
+            ZmqStatsSent(sock, 1, args.parts[i].length);
+            ZmqTrace(sock, (i < count - 1) ? ZMQ_TRACE_SENDM : ZMQ_TRACE_SEND, args.parts[i].msg, args.parts[i].length);
+        }
+    }
+    xfree(args.parts);
+    ZmqAssert(rc);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: sendv %ld parts", zsocket_type_str(sock->socket), sock->socket, count);
+    return Qtrue;
+}
+
+/*
+ * :nodoc:
+ *  Receives a raw string while the GIL is released, inflating it if compression is enabled.
+ *
+*/
+static void *rb_czmq_nogvl_recv(void *ptr)
+{
+    struct nogvl_recv_args *args = ptr;
+    errno = 0;
+    zmq_sock_wrapper *socket = args->socket;
+
+    // implement similar to zstr_recv, except that the copy to the string is done
+    // after we return with the GIL so that the ruby string object can be created
+    // from the zmq message buffer in a single copy.
+    assert (socket->socket);
+    int rc = zmq_recvmsg(socket->socket, &args->message, 0);
+    if (rc >= 0) rc = rb_czmq_decompress_msg(&socket->compression, &args->message);
+    return (void *)(intptr_t)rc;
+}
+
+/*
+ * :nodoc:
+ *  GC free callback for the zmq_msg_t backing a zero-copy String
+ *
+*/
+static void rb_czmq_free_msg_buffer_gc(void *ptr)
+{
+    zmq_msg_t *message = (zmq_msg_t *)ptr;
+    if (message) {
+        zmq_msg_close(message);
+        xfree(message);
+    }
+}
+
+/*
+ * :nodoc:
+ *  Coerces a received zmq_msg_t to a binary String. Messages of at least ZMQ.zero_copy_recv_threshold bytes (and no
+ *  less than ZMQ_MSG_VIEW_MIN_SIZE) are moved into a hidden object referenced by a frozen String pointing to the
+ *  message buffer, which thus lives for as long as the String. Such a String is not NUL terminated. Smaller messages
+ *  are copied into a terminated String. The caller still closes the given message in both cases.
+ *
+*/
+VALUE rb_czmq_msg_str(zmq_msg_t *message)
+{
+    VALUE str;
+#ifdef HAVE_RB_STR_NEW_STATIC
+    VALUE buffer;
+    zmq_msg_t *buffered;
+    if (rb_czmq_zero_copy_recv_threshold >= 0 && (long)zmq_msg_size(message) >= rb_czmq_zero_copy_recv_threshold &&
+        zmq_msg_size(message) >= ZMQ_MSG_VIEW_MIN_SIZE) {
+        buffer = Data_Make_Struct(0, zmq_msg_t, 0, rb_czmq_free_msg_buffer_gc, buffered);
+        zmq_msg_init(buffered);
+        zmq_msg_move(buffered, message);
+        str = ZmqEncode(rb_str_new_static(zmq_msg_data(buffered), zmq_msg_size(buffered)));
+        rb_ivar_set(str, intern_zmq_msg, buffer);
+        return rb_obj_freeze(str);
+    }
+#endif
+    str = rb_str_new(zmq_msg_data(message), zmq_msg_size(message));
+    return ZmqEncode(str);
+}
+
+/*
+ *  call-seq:
+ *     sock.recv =>  String or nil
+ *
+ *  Receive a string from this ZMQ socket. May block depending on the socket type.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.bind("inproc://test")
+ *     sock.recv    =>  "message"
+ *
+*/
+
+static VALUE rb_czmq_socket_recv(VALUE obj)
+{
+    struct nogvl_recv_args args;
+    VALUE result = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    args.socket = sock;
+    zmq_msg_init(&args.message);
+    errno = 0;
+
+    bool fast = ZmqRecvFastPath(sock);
+    int rc = fast ? zmq_recvmsg(sock->socket, &args.message, ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv, &args);
+    if (rc < 0) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&args.message);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqAssertSysError();
+    ZmqStatsReceived(sock, 1, rc);
+    ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&args.message), zmq_msg_size(&args.message));
+
+    result = rb_czmq_msg_str(&args.message);
+    zmq_msg_close(&args.message);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: recv \"%.*s\"", zsocket_type_str(sock->socket), sock->socket, (int)RSTRING_LEN(result), RSTRING_PTR(result));
+    return result;
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_nonblock =>  String or nil
+ *
+ *  Receive a string from this ZMQ socket. Does not block.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.bind("inproc://test")
+ *     sock.recv_nonblock    =>  "message"
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_nonblock(VALUE obj)
+{
+    struct nogvl_recv_args args;
+    errno = 0;
+    VALUE result = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+
+    zmq_msg_init(&args.message);
+
+    int rc = zmq_recvmsg(sock->socket, &args.message, ZMQ_DONTWAIT);
+    if (rc >= 0) rc = rb_czmq_decompress_msg(&sock->compression, &args.message);
+    if (rc < 0) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&args.message);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqAssertSysError();
+    ZmqStatsReceived(sock, 1, rc);
+    ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&args.message), zmq_msg_size(&args.message));
+
+    result = rb_czmq_msg_str(&args.message);
+    zmq_msg_close(&args.message);
+
+    if (sock->verbose) {
+        zclock_log ("I: %s socket %p: recv \"%.*s\"", zsocket_type_str(sock->socket), sock->socket, (int)RSTRING_LEN(result), RSTRING_PTR(result));
+    }
+
+    return result;
+}
+
+/*
+ * :nodoc:
+ *  Copies a received zmq_msg_t into a caller supplied String buffer, growing it only if its capacity is too small.
+ *
+*/
+static VALUE rb_czmq_msg_copy_into(zmq_msg_t *message, VALUE buffer)
+{
+    long size = (long)zmq_msg_size(message);
+    rb_str_modify(buffer);
+    if ((long)rb_str_capacity(buffer) < size)
+        rb_str_modify_expand(buffer, size - RSTRING_LEN(buffer));
+    MEMCPY(RSTRING_PTR(buffer), zmq_msg_data(message), char, size);
+    rb_str_set_len(buffer, size);
+    ZmqEncode(buffer);
+    return LONG2NUM(size);
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_into(buffer) =>  Fixnum or nil
+ *
+ *  Receive a message from this ZMQ socket into a preallocated String buffer, replacing its contents. The buffer is only
+ *  grown when the message does not fit its current capacity, which allows a single String to be reused for many
+ *  messages. Returns the message size in bytes. May block depending on the socket type.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.bind("inproc://test")
+ *     buf = String.new(capacity: 1024)
+ *     sock.recv_into(buf)    =>  7
+ *     buf                    =>  "message"
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_into(VALUE obj, VALUE buffer)
+{
+    struct nogvl_recv_args args;
+    VALUE result = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    Check_Type(buffer, T_STRING);
+    rb_check_frozen(buffer);
+    args.socket = sock;
+    zmq_msg_init(&args.message);
+    errno = 0;
+
+    bool fast = ZmqRecvFastPath(sock);
+    int rc = fast ? zmq_recvmsg(sock->socket, &args.message, ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv, &args);
+    if (rc < 0) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&args.message);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqAssertSysError();
+    ZmqStatsReceived(sock, 1, rc);
+    ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&args.message), zmq_msg_size(&args.message));
+
+    result = rb_czmq_msg_copy_into(&args.message, buffer);
+    zmq_msg_close(&args.message);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: recv_into %d bytes", zsocket_type_str(sock->socket), sock->socket, rc);
+    return result;
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_into_nonblock(buffer) =>  Fixnum or nil
+ *
+ *  Receive a message from this ZMQ socket into a preallocated String buffer, as per ZMQ::Socket#recv_into. Does not
+ *  block and returns nil, leaving the buffer untouched, if no message is available.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.bind("inproc://test")
+ *     buf = String.new(capacity: 1024)
+ *     sock.recv_into_nonblock(buf)    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_into_nonblock(VALUE obj, VALUE buffer)
+{
+    zmq_msg_t message;
+    VALUE result = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    Check_Type(buffer, T_STRING);
+    rb_check_frozen(buffer);
+    zmq_msg_init(&message);
+    errno = 0;
+
+    int rc = zmq_recvmsg(sock->socket, &message, ZMQ_DONTWAIT);
+    if (rc >= 0) rc = rb_czmq_decompress_msg(&sock->compression, &message);
+    if (rc < 0) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&message);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqAssertSysError();
+    ZmqStatsReceived(sock, 1, rc);
+    ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&message), zmq_msg_size(&message));
+
+    result = rb_czmq_msg_copy_into(&message, buffer);
+    zmq_msg_close(&message);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: recv_into_nonblock %d bytes", zsocket_type_str(sock->socket), sock->socket, rc);
+    return result;
+}
+
+/*
+ * :nodoc:
+ *  Raises the error a batch receive deferred for this socket, as it dropped a message after others were received.
+ *
+*/
+void rb_czmq_raise_deferred_recv_error(zmq_sock_wrapper *sock)
+{
+    int err = sock->recv_error;
+    sock->recv_error = 0;
+    if (err == EPROTO) ZmqRaiseNotFramed();
+    if (err == ENOMEM) rb_memerror();
+    rb_sys_fail(zmq_strerror(err));
+}
+
+/*
+ * :nodoc:
+ *  Allocates the frame buffers of a batch receive.
+ *
+*/
+void rb_czmq_recv_batch_init(zmq_recv_batch *batch)
+{
+    batch->nframes = 0;
+    batch->messages = 0;
+    batch->error = 0;
+    batch->capacity = ZMQ_RECV_BATCH_INITIAL_CAPA;
+    batch->frames = malloc(sizeof(zmq_msg_t) * batch->capacity);
+    batch->more = malloc(batch->capacity);
+    batch->owners = malloc(sizeof(int) * batch->capacity);
+    if (batch->frames == NULL || batch->more == NULL || batch->owners == NULL) {
+        rb_czmq_recv_batch_free((VALUE)batch);
+        rb_memerror();
+    }
+}
+
+/*
+ * :nodoc:
+ *  Releases all frames of a batch receive and its buffers. Used as an ensure callback, thus also when a pending
+ *  interrupt raises once the GVL is reacquired.
+ *
+*/
+VALUE rb_czmq_recv_batch_free(VALUE ptr)
+{
+    zmq_recv_batch *batch = (zmq_recv_batch *)ptr;
+    long i;
+    for (i = 0; i < batch->nframes; i++) zmq_msg_close(&batch->frames[i]);
+    free(batch->frames);
+    free(batch->more);
+    free(batch->owners);
+    batch->frames = NULL;
+    batch->more = NULL;
+    batch->owners = NULL;
+    batch->nframes = 0;
+    return Qnil;
+}
+
+/*
+ * :nodoc:
+ *  Grows the frame buffers of a batch receive. Returns false if out of memory.
+ *
+*/
+static bool rb_czmq_recv_batch_grow(zmq_recv_batch *batch)
+{
+    long capacity = batch->capacity * 2;
+    zmq_msg_t *frames;
+    char *more;
+    int *owners;
+    frames = realloc(batch->frames, sizeof(zmq_msg_t) * capacity);
+    if (frames == NULL) return false;
+    batch->frames = frames;
+    more = realloc(batch->more, capacity);
+    if (more == NULL) return false;
+    batch->more = more;
+    owners = realloc(batch->owners, sizeof(int) * capacity);
+    if (owners == NULL) return false;
+    batch->owners = owners;
+    batch->capacity = capacity;
+    return true;
+}
+
+/*
+ * :nodoc:
+ *  Receives and discards the remaining parts of a multipart message, so that they don't become the next message.
+ *
+*/
+static void rb_czmq_discard_parts(void *socket)
+{
+    zmq_msg_t part;
+    int more;
+    do {
+        zmq_msg_init(&part);
+        if (zmq_recvmsg(socket, &part, 0) == -1) {
+            zmq_msg_close(&part);
+            return;
+        }
+        more = zmq_msg_more(&part);
+        zmq_msg_close(&part);
+    } while (more);
+}
+
+/*
+ * :nodoc:
+ *  Receives up to max messages from a socket into a batch, the first with the given flags and the others without
+ *  blocking. Safe to call without the GVL. Multipart messages are received whole or not at all - if a message is
+ *  dropped half way (out of memory or a payload not framed for compression), its remaining parts are discarded and
+ *  the error is deferred to the next receive on the socket. Other receive errors are stored in the batch. Returns the
+ *  number of messages received.
+ *
+*/
+long rb_czmq_recv_batch_drain(zmq_recv_batch *batch, zmq_sock_wrapper *sock, long max, int flags, int owner)
+{
+    long received = 0, start = batch->nframes;
+    zmq_msg_t *frame;
+    int dropped = 0;
+    while (received < max) {
+        if (batch->nframes == batch->capacity && !rb_czmq_recv_batch_grow(batch)) {
+            dropped = ENOMEM;
+            break;
+        }
+        frame = &batch->frames[batch->nframes];
+        zmq_msg_init(frame);
+        if (zmq_recvmsg(sock->socket, frame, flags) == -1) {
+            zmq_msg_close(frame);
+            if (zmq_errno() != EAGAIN && batch->error == 0) batch->error = zmq_errno();
+            break;
+        }
+        batch->more[batch->nframes] = zmq_msg_more(frame) ? 1 : 0;
+        if (rb_czmq_decompress_msg(&sock->compression, frame) < 0) {
+            zmq_msg_close(frame);
+            dropped = EPROTO;
+            break;
+        }
+        batch->owners[batch->nframes] = owner;
+        /* remaining parts of a multipart message are delivered atomically and are already queued */
+        if (batch->more[batch->nframes++]) {
+            flags = 0;
+            continue;
+        }
+        received++;
+        batch->messages++;
+        start = batch->nframes;
+        flags = ZMQ_DONTWAIT;
+    }
+    if (dropped == EPROTO) {
+        if (batch->more[batch->nframes]) rb_czmq_discard_parts(sock->socket);
+        sock->recv_error = EPROTO;
+    } else if (dropped == ENOMEM && batch->nframes > start) {
+        rb_czmq_discard_parts(sock->socket);
+        sock->recv_error = ENOMEM;
+    } else if (dropped == ENOMEM && batch->error == 0) {
+        /* out of memory between messages doesn't drop anything - the next message stays queued */
+        batch->error = ENOMEM;
+    }
+    while (batch->nframes > start) zmq_msg_close(&batch->frames[--batch->nframes]);
+    return received;
+}
+
+/*
+ * :nodoc:
+ *  Returns the message starting at the given frame of a batch - a String for single part messages and an Array of
+ *  Strings for multipart messages - and advances to the next message.
+ *
+*/
+VALUE rb_czmq_recv_batch_message(zmq_recv_batch *batch, long *frame)
+{
+    VALUE parts = Qnil;
+    while (batch->more[*frame]) {
+        if (NIL_P(parts)) parts = rb_ary_new();
+        rb_ary_push(parts, rb_czmq_msg_str(&batch->frames[(*frame)++]));
+    }
+    if (NIL_P(parts)) return rb_czmq_msg_str(&batch->frames[(*frame)++]);
+    rb_ary_push(parts, rb_czmq_msg_str(&batch->frames[(*frame)++]));
+    return parts;
+}
+
+/*
+ * :nodoc:
+ *  Receives a batch of messages while the GIL is released. Blocks (or polls up to the timeout) for the first message
+ *  only and then drains whatever else is queued without blocking.
+ *
+*/
+static void *rb_czmq_nogvl_recv_batch(void *ptr)
+{
+    struct nogvl_recv_batch_args *args = ptr;
+    zmq_pollitem_t item;
+    int rc, flags = 0;
+    errno = 0;
+    zmq_sock_wrapper *socket = args->socket;
+    if (args->timeout >= 0) {
+        item.socket = socket->socket;
+        item.fd = 0;
+        item.events = ZMQ_POLLIN;
+        item.revents = 0;
+        rc = zmq_poll(&item, 1, args->timeout);
+        if (rc == -1) args->batch.error = zmq_errno();
+        if (rc <= 0) return (void *)(intptr_t)rc;
+        flags = ZMQ_DONTWAIT;
+    }
+    return (void *)(intptr_t)rb_czmq_recv_batch_drain(&args->batch, socket, args->max, flags, 0);
+}
+
+/*
+ * :nodoc:
+ *  Receives a batch and builds the messages received, with the batch released by an ensure callback.
+ *
+*/
+static VALUE rb_czmq_socket_recv_batch_body(VALUE ptr)
+{
+    struct nogvl_recv_batch_args *args = (struct nogvl_recv_batch_args *)ptr;
+    zmq_sock_wrapper *sock = args->socket;
+    long i, frame = 0;
+    ZmqCallWithoutGVLDeferInts(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv_batch, args);
+    for (i = 0; i < args->batch.nframes; i++) {
+        ZmqStatsReceived(sock, 1, zmq_msg_size(&args->batch.frames[i]));
+        ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&args->batch.frames[i]), zmq_msg_size(&args->batch.frames[i]));
+    }
+    args->result = rb_ary_new2(args->batch.messages);
+    for (i = 0; i < args->batch.messages; i++) rb_ary_push(args->result, rb_czmq_recv_batch_message(&args->batch, &frame));
+    return args->result;
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_batch(100)        =>  Array
+ *     sock.recv_batch(100, 500)   =>  Array
+ *
+ *  Receives up to max messages from this ZMQ socket with a single GVL release. Blocks for the first message, or for up
+ *  to timeout milliseconds if given, and then drains any other queued messages without blocking. Single part messages
+ *  are returned as Strings and multipart messages as an Array of Strings. Returns an empty Array if no message has
+ *  been received. Errors are raised if no message has been received - a message dropped after others were received
+ *  (a payload not framed for compression, or out of memory) raises on the next receive instead.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PULL)
+ *     sock.bind("inproc://test")
+ *     sock.recv_batch(100)    =>  ["message", ["multi", "part"]]
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_batch(int argc, VALUE *argv, VALUE obj)
+{
+    VALUE max, timeout;
+    struct nogvl_recv_batch_args args;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    rb_scan_args(argc, argv, "11", &max, &timeout);
+    Check_Type(max, T_FIXNUM);
+    if (FIX2LONG(max) <= 0) rb_raise(rb_eArgError, "batch size must be greater than zero!");
+    if (!NIL_P(timeout)) Check_Type(timeout, T_FIXNUM);
+    args.socket = sock;
+    args.max = FIX2LONG(max);
+    args.timeout = NIL_P(timeout) ? -1 : FIX2LONG(timeout);
+    args.result = Qnil;
+    rb_czmq_recv_batch_init(&args.batch);
+
+    rb_ensure(rb_czmq_socket_recv_batch_body, (VALUE)&args, rb_czmq_recv_batch_free, (VALUE)&args.batch);
+    /* interrupts raise once messages received are built, and the batch released */
+    rb_thread_check_ints();
+    if (args.batch.messages == 0) {
+        ZmqAssertNoDeferredRecvError(sock);
+        if (args.batch.error == ENOMEM) rb_memerror();
+        errno = args.batch.error;
+        ZmqStatsError(sock);
+        /* an interrupted receive returns flow to Ruby for interrupt handling, like ZMQ::Poller#poll */
+        if (args.batch.error && args.batch.error != EINTR) ZmqRaiseSysError();
+    }
+
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: recv_batch %ld messages", zsocket_type_str(sock->socket), sock->socket, args.batch.messages);
+    return args.result;
+}
+
+/*
+ * :nodoc:
+ *  Sends a prepared message while the GIL is released, framing it for compression first if still pending.
+ *
+*/
+static void *rb_czmq_nogvl_send_msg(void *ptr)
+{
+    struct nogvl_send_msg_args *args = ptr;
+    errno = 0;
+    zmq_sock_wrapper *socket = args->socket;
+    if (args->compress) {
+        if (rb_czmq_compress_msg_in_place(&socket->compression, &args->message) == -1) return (void *)(intptr_t)-1;
+        args->compress = false;
+    }
+    return (void *)(intptr_t)zmq_sendmsg(socket->socket, &args->message, args->flags);
+}
+
+/*
+ *  call-seq:
+ *     sock.send_packed(obj)  =>  boolean
+ *
+ *  Encodes an object as MessagePack straight into the buffer of a message and sends it to this ZMQ socket, without
+ *  an intermediate String. Supports nil, true, false, Integer, Float, String, Symbol and Arrays and Hashes thereof.
+ *  Binary Strings are packed as bin, others as str. Raises TypeError for any other object.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PUSH)
+ *     sock.connect("inproc://test")
+ *     sock.send_packed("id" => 1, "tags" => ["a", "b"])    =>  true
+ *
+*/
+
+static VALUE rb_czmq_socket_send_packed(VALUE obj, VALUE value)
+{
+    int rc;
+    bool fast;
+    size_t size;
+    struct nogvl_send_msg_args args;
+    zmq_msgpack_buffer buffer;
+    zmq_trace_capture capture;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    buffer.data = NULL;
+    buffer.size = buffer.capa = 0;
+    rb_czmq_msgpack_pack(&buffer, value);
+    size = buffer.size;
+    ZmqTraceCapture(capture, buffer.data, size, size);
+    args.socket = sock;
+    args.flags = 0;
+    zmq_msg_init_data(&args.message, buffer.data, size, rb_czmq_msgpack_free, NULL);
+    args.compress = ZmqCompressing(&sock->compression);
+    fast = ZmqSendFastPath(sock, size);
+    errno = 0;
+    rc = 0;
+    if (fast && args.compress) {
+        /* below the compression threshold, only prepends the header */
+        rc = rb_czmq_compress_msg_in_place(&sock->compression, &args.message);
+        args.compress = false;
+    }
+    if (rc == 0) rc = fast ? zmq_sendmsg(sock->socket, &args.message, ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_send_msg, &args);
+    if (rc == -1) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&args.message);
+    }
+    ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, size);
+    ZmqTraceCaptured(sock, ZMQ_TRACE_SEND, capture);
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: send_packed %lu bytes", zsocket_type_str(sock->socket), sock->socket, (unsigned long)size);
+    return Qtrue;
+}
+
+static VALUE rb_czmq_msgpack_unpack_msg(VALUE ptr)
+{
+    zmq_msg_t *message = (zmq_msg_t *)ptr;
+    return rb_czmq_msgpack_unpack(zmq_msg_data(message), zmq_msg_size(message));
+}
+
+/*
+ *  call-seq:
+ *     sock.recv_unpacked  =>  Object or nil
+ *
+ *  Receives a message from this ZMQ socket and decodes it as MessagePack directly from the message buffer. Returns
+ *  nil if the receive failed. Raises ZMQ::Error if the message isn't valid MessagePack. May block depending on the
+ *  socket type.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PULL)
+ *     sock.bind("inproc://test")
+ *     sock.recv_unpacked    =>  {"id" => 1, "tags" => ["a", "b"]}
+ *
+*/
+
+static VALUE rb_czmq_socket_recv_unpacked(VALUE obj)
+{
+    int state = 0;
+    struct nogvl_recv_args args;
+    VALUE result = Qnil;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    args.socket = sock;
+    zmq_msg_init(&args.message);
+    errno = 0;
+
+    bool fast = ZmqRecvFastPath(sock);
+    int rc = fast ? zmq_recvmsg(sock->socket, &args.message, ZMQ_DONTWAIT) : -1;
+    if (rc == -1 && ZmqFastPathMissed(fast))
+        rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv, &args);
+    if (rc < 0) {
+        ZmqStatsError(sock);
+        zmq_msg_close(&args.message);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqAssertSysError();
+    ZmqStatsReceived(sock, 1, rc);
+    ZmqTrace(sock, ZMQ_TRACE_RECV, zmq_msg_data(&args.message), zmq_msg_size(&args.message));
+    if (sock->verbose)
+        zclock_log ("I: %s socket %p: recv_unpacked %d bytes", zsocket_type_str(sock->socket), sock->socket, rc);
+
+    result = rb_protect(rb_czmq_msgpack_unpack_msg, (VALUE)&args.message, &state);
+    zmq_msg_close(&args.message);
+    if (state) rb_jump_tag(state);
+    return result;
+}
+
+/*
+ * :nodoc:
+ *  Sends a frame like zframe_send, framing it for compression if enabled. The frame is only destroyed once sent, unless
+ *  ZFRAME_REUSE is set, and left intact on error.
+ *
+*/
+static int rb_czmq_zframe_send(zmq_sock_wrapper *sock, zframe_t **frame, int flags)
+{
+    zframe_t *framed = NULL;
+    if (!ZmqCompressing(&sock->compression)) return zframe_send(frame, sock->socket, flags);
+    framed = rb_czmq_compress_frame(&sock->compression, *frame);
+    if (framed == NULL) return -1;
+    if (zframe_send(&framed, sock->socket, flags & ~ZFRAME_REUSE) == -1) {
+        zframe_destroy(&framed);
+        return -1;
+    }
+    if ((flags & ZFRAME_REUSE) == 0) zframe_destroy(frame);
+    return 0;
+}
+
+/*
+ * :nodoc:
+ *  Sends a frame while the GIL is released.
+ *
+*/
+static void *rb_czmq_nogvl_send_frame(void *ptr)
+{
+    struct nogvl_send_frame_args *args = ptr;
+    errno = 0;
+    zmq_sock_wrapper *socket = args->socket;
+    return (void *)(intptr_t)rb_czmq_zframe_send(socket, &(args->frame), args->flags);
+}
+
+/*
+ *  call-seq:
+ *     sock.send_frame(frame) =>  nil
+ *
+ *  Sends a ZMQ::Frame instance to this socket.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:REP)
+ *     sock.bind("inproc://test")
+ *     frame = ZMQ::Frame("frame")
+ *     sock.send_frame(frame)    =>  nil
+ *     frame = ZMQ::Frame("multi")
+ *     sock.send_frame(frame, ZMQ::Frame::MORE)
+ *
+*/
+
+static VALUE rb_czmq_socket_send_frame(int argc, VALUE *argv, VALUE obj)
+{
+    struct nogvl_send_frame_args args;
+    zmq_trace_capture capture;
+    VALUE frame_obj;
+    VALUE flags;
+    char print_prefix[255];
+    char *cur_time = NULL;
+    zframe_t *print_frame = NULL;
+    size_t size;
+    int rc, flgs;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    rb_scan_args(argc, argv, "11", &frame_obj, &flags);
+    ZmqGetFrame(frame_obj);
     ZmqAssertFrameOwnedNoMessage(frame);
 
     if (NIL_P(flags)) {
@@ -674,11 +1766,16 @@ static VALUE rb_czmq_socket_send_frame(int argc, VALUE *argv, VALUE obj)
         cur_time = rb_czmq_formatted_current_time();
         print_frame = (flgs & ZFRAME_REUSE) ? frame->frame : zframe_dup(frame->frame);
     }
+    size = zframe_size(frame->frame);
+    ZmqTraceCapture(capture, zframe_data(frame->frame), size, size);
     args.socket = sock;
     args.frame = frame->frame;
     args.flags = flgs;
-    rc = (int)rb_thread_call_without_gvl(rb_czmq_nogvl_send_frame, (void *)&args, RUBY_UBF_IO, 0);
+    rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_send_frame, &args);
+    if (rc == -1) ZmqStatsError(sock);
     ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, size);
+    ZmqTraceCaptured(sock, ZMQ_TRACE_SEND_FRAME, capture);
     if ((flgs & ZFRAME_REUSE) == 0) {
         /* frame has been destroyed, clear the owns flag */
         frame->flags &= ~ZMQ_FRAME_OWNED;
@@ -687,18 +1784,96 @@ static VALUE rb_czmq_socket_send_frame(int argc, VALUE *argv, VALUE obj)
     return Qtrue;
 }
 
+/*
+ *  call-seq:
+ *     sock.send_frame_nonblock(frame) =>  boolean
+ *
+ *  Sends a ZMQ::Frame instance to this socket without blocking and without releasing the GIL. Returns false, leaving
+ *  the frame untouched, if it could not be queued right away. Accepts the same flags as ZMQ::Socket#send_frame.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PUSH)
+ *     sock.bind("inproc://test")
+ *     frame = ZMQ::Frame("frame")
+ *     sock.send_frame_nonblock(frame)    =>  true
+ *
+*/
+
+static VALUE rb_czmq_socket_send_frame_nonblock(int argc, VALUE *argv, VALUE obj)
+{
+    zmq_trace_capture capture;
+    VALUE frame_obj;
+    VALUE flags;
+    char print_prefix[255];
+    char *cur_time = NULL;
+    zframe_t *print_frame = NULL;
+    size_t size;
+    int rc, flgs;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    rb_scan_args(argc, argv, "11", &frame_obj, &flags);
+    ZmqGetFrame(frame_obj);
+    ZmqAssertFrameOwnedNoMessage(frame);
+
+    if (NIL_P(flags)) {
+        flgs = 0;
+    } else {
+        if (SYMBOL_P(flags)) flags = rb_const_get_at(rb_cZmqFrame, rb_to_id(flags));
+        Check_Type(flags, T_FIXNUM);
+        flgs = FIX2INT(flags);
+    }
+
+    if (sock->verbose) {
+        cur_time = rb_czmq_formatted_current_time();
+        print_frame = (flgs & ZFRAME_REUSE) ? frame->frame : zframe_dup(frame->frame);
+    }
+    size = zframe_size(frame->frame);
+    ZmqTraceCapture(capture, zframe_data(frame->frame), size, size);
+    errno = 0;
+    rc = rb_czmq_zframe_send(sock, &(frame->frame), flgs | ZFRAME_DONTWAIT);
+    if (rc == -1) ZmqStatsError(sock);
+    if (rc == -1 && zmq_errno() == EAGAIN) {
+        if (print_frame && print_frame != frame->frame) zframe_destroy(&print_frame);
+        if (cur_time) xfree(cur_time);
+        return Qfalse;
+    }
+    ZmqAssert(rc);
+    ZmqStatsSent(sock, 1, size);
+    ZmqTraceCaptured(sock, ZMQ_TRACE_SEND_FRAME, capture);
+    if ((flgs & ZFRAME_REUSE) == 0) {
+        /* frame has been destroyed, clear the owns flag */
+        frame->flags &= ~ZMQ_FRAME_OWNED;
+    }
+    if (sock->verbose) ZmqDumpFrame("send_frame_nonblock", print_frame);
+    return Qtrue;
+}
+
 /*
  * :nodoc:
  *  Sends a message while the GIL is released.
  *
 */
-static VALUE rb_czmq_nogvl_send_message(void *ptr)
+static void *rb_czmq_nogvl_send_message(void *ptr)
 {
     struct nogvl_send_message_args *args = ptr;
     zmq_sock_wrapper *socket = args->socket;
+    zframe_t *frame = NULL;
+    int rc = 0;
     errno = 0;
-    zmsg_send(&(args->message), socket->socket);
-    return Qnil;
+    if (ZmqCompressing(&socket->compression)) {
+        while (rc == 0 && (frame = zmsg_pop(args->message))) {
+            rc = rb_czmq_zframe_send(socket, &frame, zmsg_size(args->message) ? ZFRAME_MORE : 0);
+            if (rc == -1) zframe_destroy(&frame);
+        }
+        zmsg_destroy(&(args->message));
+    } else {
+        rc = zmsg_send(&(args->message), socket->socket);
+    }
+    return (void *)(intptr_t)rc;
 }
 
 /*
@@ -720,33 +1895,120 @@ static VALUE rb_czmq_nogvl_send_message(void *ptr)
 static VALUE rb_czmq_socket_send_message(VALUE obj, VALUE message_obj)
 {
     struct nogvl_send_message_args args;
+    zmq_trace_capture capture;
+    size_t parts, size;
     zmsg_t *print_message = NULL;
+    int rc;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     ZmqGetMessage(message_obj);
     ZmqAssertMessageOwned(message);
     if (sock->verbose) print_message = zmsg_dup(message->message);
+    ZmqTraceCaptureMessage(capture, message->message);
+    parts = zmsg_size(message->message);
+    size = zmsg_content_size(message->message);
     args.socket = sock;
     args.message = message->message;
-    rb_thread_call_without_gvl(rb_czmq_nogvl_send_message, (void *)&args, RUBY_UBF_IO, 0);
+    rc = (int)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_SEND, rb_czmq_nogvl_send_message, &args);
+    /* the message is consumed whether or not it could be sent */
     message->flags &= ~ZMQ_MESSAGE_OWNED;
+    if (rc == -1) {
+        ZmqStatsError(sock);
+    } else {
+        ZmqStatsSent(sock, parts, size);
+        ZmqTraceCaptured(sock, ZMQ_TRACE_SEND_MESSAGE, capture);
+    }
     if (sock->verbose) ZmqDumpMessage("send_message", print_message);
     return Qnil;
 }
 
 /*
  * :nodoc:
- *  Receives a frame while the GIL is released.
+ *  Sends all frames of a message with ZMQ_DONTWAIT. The message is left intact if the first frame can't be queued,
+ *  which is the only one libzmq may refuse once the high water mark is reached. Destroys the message otherwise.
+ *
+*/
+static int rb_czmq_send_message_nonblock(zmq_sock_wrapper *sock, zmsg_t **message)
+{
+    zframe_t *frame = zmsg_pop(*message);
+    int rc = 0;
+    errno = 0;
+    if (frame && rb_czmq_zframe_send(sock, &frame, (zmsg_size(*message) ? ZFRAME_MORE : 0) | ZFRAME_DONTWAIT) == -1) {
+        zmsg_push(*message, frame);
+        return -1;
+    }
+    while (rc == 0 && (frame = zmsg_pop(*message))) {
+        rc = rb_czmq_zframe_send(sock, &frame, (zmsg_size(*message) ? ZFRAME_MORE : 0) | ZFRAME_DONTWAIT);
+        if (rc == -1) zframe_destroy(&frame);
+    }
+    zmsg_destroy(message);
+    return rc;
+}
+
+/*
+ *  call-seq:
+ *     sock.send_message_nonblock(msg) =>  boolean
+ *
+ *  Sends a ZMQ::Message instance to this socket without blocking and without releasing the GIL. Returns false, leaving
+ *  the message untouched, if it could not be queued right away.
+ *
+ * === Examples
+ *     ctx = ZMQ::Context.new
+ *     sock = ctx.socket(:PUSH)
+ *     sock.bind("inproc://test")
+ *     msg = ZMQ::Message.new
+ *     msg.push ZMQ::Frame("header")
+ *     sock.send_message_nonblock(msg)   =>  true
+ *
+*/
+
+static VALUE rb_czmq_socket_send_message_nonblock(VALUE obj, VALUE message_obj)
+{
+    int rc;
+    zmq_trace_capture capture;
+    size_t parts, size;
+    zmsg_t *print_message = NULL;
+    zmq_sock_wrapper *sock = NULL;
+    GetZmqSocket(obj);
+    ZmqAssertSocketNotPending(sock, "can only send on a bound or connected socket!");
+    ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
+    ZmqGetMessage(message_obj);
+    ZmqAssertMessageOwned(message);
+    if (sock->verbose) print_message = zmsg_dup(message->message);
+    ZmqTraceCaptureMessage(capture, message->message);
+    parts = zmsg_size(message->message);
+    size = zmsg_content_size(message->message);
+    rc = rb_czmq_send_message_nonblock(sock, &message->message);
+    if (message->message == NULL) message->flags &= ~ZMQ_MESSAGE_OWNED;
+    if (rc == -1) {
+        ZmqStatsError(sock);
+        if (print_message) zmsg_destroy(&print_message);
+        if (zmq_errno() == EAGAIN && message->message) return Qfalse;
+        ZmqAssert(rc);
+    }
+    ZmqStatsSent(sock, parts, size);
+    ZmqTraceCaptured(sock, ZMQ_TRACE_SEND_MESSAGE, capture);
+    if (sock->verbose) ZmqDumpMessage("send_message_nonblock", print_message);
+    return Qtrue;
+}
+
+/*
+ * :nodoc:
+ *  Receives a frame while the GIL is released, inflating it if compression is enabled.
  *
 */
-static VALUE rb_czmq_nogvl_recv_frame(void *ptr)
+static void *rb_czmq_nogvl_recv_frame(void *ptr)
 {
     struct nogvl_recv_args *args = ptr;
     errno = 0;
     zmq_sock_wrapper *socket = args->socket;
-    return (VALUE)zframe_recv(socket->socket);
+    zframe_t *frame = zframe_recv(socket->socket);
+    if (frame) frame = rb_czmq_decompress_frame(&socket->compression, frame);
+    return frame;
 }
 
 /*
@@ -766,16 +2028,28 @@ static VALUE rb_czmq_nogvl_recv_frame(void *ptr)
 static VALUE rb_czmq_socket_recv_frame(VALUE obj)
 {
     zframe_t *frame = NULL;
+    bool fast;
     struct nogvl_recv_args args;
     char print_prefix[255];
     char *cur_time = NULL;
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
-    frame = (zframe_t *)rb_thread_call_without_gvl(rb_czmq_nogvl_recv_frame, (void *)&args, RUBY_UBF_IO, 0);
-    if (frame == NULL) return Qnil;
+    fast = ZmqRecvFastPath(sock);
+    frame = fast ? zframe_recv_nowait(sock->socket) : NULL;
+    if (frame == NULL && ZmqFastPathMissed(fast))
+        frame = (zframe_t *)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv_frame, &args);
+    if (frame == NULL) {
+        ZmqStatsError(sock);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqStatsReceived(sock, 1, zframe_size(frame));
+    ZmqTrace(sock, ZMQ_TRACE_RECV_FRAME, zframe_data(frame), zframe_size(frame));
     if (sock->verbose) {
         cur_time = rb_czmq_formatted_current_time();
         ZmqDumpFrame("recv_frame", frame);
@@ -806,9 +2080,18 @@ static VALUE rb_czmq_socket_recv_frame_nonblock(VALUE obj)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     frame = zframe_recv_nowait(sock->socket);
-    if (frame == NULL) return Qnil;
+    if (frame) frame = rb_czmq_decompress_frame(&sock->compression, frame);
+    if (frame == NULL) {
+        ZmqStatsError(sock);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqStatsReceived(sock, 1, zframe_size(frame));
+    ZmqTrace(sock, ZMQ_TRACE_RECV_FRAME, zframe_data(frame), zframe_size(frame));
     if (sock->verbose) {
         cur_time = rb_czmq_formatted_current_time();
         ZmqDumpFrame("recv_frame_nonblock", frame);
@@ -818,15 +2101,17 @@ static VALUE rb_czmq_socket_recv_frame_nonblock(VALUE obj)
 
 /*
  * :nodoc:
- *  Receives a message while the GIL is released.
+ *  Receives a message while the GIL is released, inflating its frames if compression is enabled.
  *
 */
-static VALUE rb_czmq_nogvl_recv_message(void *ptr)
+static void *rb_czmq_nogvl_recv_message(void *ptr)
 {
     struct nogvl_recv_args *args = ptr;
     errno = 0;
     zmq_sock_wrapper *socket = args->socket;
-    return (VALUE)zmsg_recv(socket->socket);
+    zmsg_t *message = zmsg_recv(socket->socket);
+    if (message && rb_czmq_decompress_message(&socket->compression, message) < 0) zmsg_destroy(&message);
+    return message;
 }
 
 /*
@@ -850,10 +2135,25 @@ static VALUE rb_czmq_socket_recv_message(VALUE obj)
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
     ZmqAssertSocketNotPending(sock, "can only receive on a bound or connected socket!");
+    ZmqAssertNoDeferredRecvError(sock);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
-    message = (zmsg_t *)rb_thread_call_without_gvl(rb_czmq_nogvl_recv_message, (void *)&args, RUBY_UBF_IO, 0);
-    if (message == NULL) return Qnil;
+    /* all parts of a multipart message arrive atomically, thus zmsg_recv won't block once the first part is queued */
+    errno = 0;
+    if (ZmqRecvFastPath(sock) && (zsocket_events(sock->socket) & ZMQ_POLLIN)) {
+        message = zmsg_recv(sock->socket);
+    } else {
+        message = (zmsg_t *)ZmqCallWithoutGVL(sock, ZMQ_LATENCY_RECV, rb_czmq_nogvl_recv_message, &args);
+    }
+    if (message == NULL) {
+        ZmqStatsError(sock);
+        ZmqAssertDecompressed();
+        return Qnil;
+    }
+    ZmqStatsReceived(sock, zmsg_size(message), zmsg_content_size(message));
+    if (rb_czmq_trace && zmsg_first(message))
+        rb_czmq_trace_record(sock->socket, ZMQ_TRACE_RECV_MESSAGE, zframe_data(zmsg_first(message)), zframe_size(zmsg_first(message)), zmsg_content_size(message));
     if (sock->verbose) ZmqDumpMessage("recv_message", message);
     return rb_czmq_alloc_message(message);
 }
@@ -892,6 +2192,7 @@ static VALUE rb_czmq_socket_poll(VALUE obj, VALUE timeout)
     GetZmqSocket(obj);
     Check_Type(timeout, T_FIXNUM);
     ZmqSockGuardCrossThread(sock);
+    ZmqSocketTouched(sock);
     args.socket = sock;
     args.timeout = FIX2INT(timeout);
     readable = (bool)rb_thread_call_without_gvl(rb_czmq_nogvl_poll, (void *)&args, RUBY_UBF_IO, 0);
@@ -1634,6 +2935,7 @@ static VALUE rb_czmq_socket_opt_events(VALUE obj)
 {
     zmq_sock_wrapper *sock = NULL;
     GetZmqSocket(obj);
+    ZmqSocketTouched(sock);
     return INT2NUM(zsocket_events(sock->socket));
 }
 
@@ -1904,6 +3206,7 @@ void _init_rb_czmq_socket()
     intern_on_closed = rb_intern("on_closed");
     intern_on_close_failed = rb_intern("on_close_failed");
     intern_on_disconnected = rb_intern("on_disconnected");
+    intern_zmq_msg = rb_intern("__zmq_msg");
 
     rb_define_const(rb_cZmqSocket, "PENDING", INT2NUM(ZMQ_SOCKET_PENDING));
     rb_define_const(rb_cZmqSocket, "BOUND", INT2NUM(ZMQ_SOCKET_BOUND));
@@ -1920,15 +3223,33 @@ void _init_rb_czmq_socket()
     rb_define_method(rb_cZmqSocket, "fd", rb_czmq_socket_fd, 0);
     rb_define_alias(rb_cZmqSocket, "to_i", "fd");
     rb_define_method(rb_cZmqSocket, "verbose=", rb_czmq_socket_set_verbose, 1);
+    rb_define_method(rb_cZmqSocket, "fast_path=", rb_czmq_socket_set_fast_path, 1);
+    rb_define_method(rb_cZmqSocket, "fast_path?", rb_czmq_socket_fast_path_p, 0);
+    rb_define_method(rb_cZmqSocket, "compression=", rb_czmq_socket_set_compression, 1);
+    rb_define_method(rb_cZmqSocket, "compression", rb_czmq_socket_compression, 0);
+    rb_define_method(rb_cZmqSocket, "stats", rb_czmq_socket_stats, 0);
+    rb_define_method(rb_cZmqSocket, "reset_stats", rb_czmq_socket_reset_stats, 0);
+    rb_define_method(rb_cZmqSocket, "send_latency", rb_czmq_socket_send_latency, 0);
+    rb_define_method(rb_cZmqSocket, "recv_latency", rb_czmq_socket_recv_latency, 0);
     rb_define_method(rb_cZmqSocket, "send", rb_czmq_socket_send, 1);
     rb_define_method(rb_cZmqSocket, "sendm", rb_czmq_socket_sendm, 1);
+    rb_define_method(rb_cZmqSocket, "send_nonblock", rb_czmq_socket_send_nonblock, 1);
+    rb_define_method(rb_cZmqSocket, "sendm_nonblock", rb_czmq_socket_sendm_nonblock, 1);
+    rb_define_method(rb_cZmqSocket, "sendv", rb_czmq_socket_sendv, 1);
     rb_define_method(rb_cZmqSocket, "send_frame", rb_czmq_socket_send_frame, -1);
+    rb_define_method(rb_cZmqSocket, "send_frame_nonblock", rb_czmq_socket_send_frame_nonblock, -1);
     rb_define_method(rb_cZmqSocket, "send_message", rb_czmq_socket_send_message, 1);
+    rb_define_method(rb_cZmqSocket, "send_message_nonblock", rb_czmq_socket_send_message_nonblock, 1);
+    rb_define_method(rb_cZmqSocket, "send_packed", rb_czmq_socket_send_packed, 1);
     rb_define_method(rb_cZmqSocket, "recv", rb_czmq_socket_recv, 0);
     rb_define_method(rb_cZmqSocket, "recv_nonblock", rb_czmq_socket_recv_nonblock, 0);
+    rb_define_method(rb_cZmqSocket, "recv_into", rb_czmq_socket_recv_into, 1);
+    rb_define_method(rb_cZmqSocket, "recv_into_nonblock", rb_czmq_socket_recv_into_nonblock, 1);
+    rb_define_method(rb_cZmqSocket, "recv_batch", rb_czmq_socket_recv_batch, -1);
     rb_define_method(rb_cZmqSocket, "recv_frame", rb_czmq_socket_recv_frame, 0);
     rb_define_method(rb_cZmqSocket, "recv_frame_nonblock", rb_czmq_socket_recv_frame_nonblock, 0);
     rb_define_method(rb_cZmqSocket, "recv_message", rb_czmq_socket_recv_message, 0);
+    rb_define_method(rb_cZmqSocket, "recv_unpacked", rb_czmq_socket_recv_unpacked, 0);
     rb_define_method(rb_cZmqSocket, "poll", rb_czmq_socket_poll, 1);
 
     rb_define_method(rb_cZmqSocket, "sndhwm", rb_czmq_socket_opt_sndhwm, 0);
@@ -10,12 +10,28 @@
 #define ZMQ_SOCKET_CONNECTED 0x04
 #define ZMQ_SOCKET_DISCONNECTED 0x08
 
+/* Native I/O counters, updated with the GVL held. Every message part counts as a message. */
+typedef struct {
+    uint64_t messages_sent;
+    uint64_t bytes_sent;
+    uint64_t messages_received;
+    uint64_t bytes_received;
+    uint64_t eagain;
+    uint64_t eintr;
+    uint64_t gvl_releases;
+    uint64_t blocked_ns;
+} zmq_sock_stats;
+
+#define ZMQ_LATENCY_SEND 0
+#define ZMQ_LATENCY_RECV 1
+
 typedef struct {
     zctx_t *ctx;
     void *socket;
     void *ctx_wrapper; // zmq_ctx_wrapper - can't be defined yet, circular header includes.
     int flags;
     bool verbose;
+    bool fast_path;
     int state;
     VALUE endpoints;
     VALUE thread;
@@ -23,6 +39,11 @@ typedef struct {
     VALUE monitor_endpoint;
     VALUE monitor_handler;
     VALUE monitor_thread;
+    zmq_sock_stats stats;
+    zmq_histogram *latency[2]; /* allocated on the first blocking send / receive */
+    zmq_compression compression;
+    int recv_error; /* errno of a message dropped by a batch receive after others were returned, raised by the next receive */
+    void *registrations; /* zmq_poller_entry - registrations with epoll backed pollers, can't be defined yet */
 } zmq_sock_wrapper;
 
 #define ZmqAssertSocket(obj) ZmqAssertType(obj, rb_cZmqSocket, "ZMQ::Socket")
@@ -45,6 +66,39 @@ typedef struct {
       zmsg_dump((message)); \
   } while(0)
 
+/* Compressing sockets skip the fast path for payloads they deflate or inflate, to keep that work off the GVL */
+#define ZmqSendFastPath(sock, size) ((sock)->fast_path && !ZmqCompressible(&(sock)->compression, (size)))
+#define ZmqRecvFastPath(sock) ((sock)->fast_path && !ZmqCompressing(&(sock)->compression))
+
+/* True if the GVL should be released for a blocking call - either the fast path was skipped, or the non-blocking
+   attempt with the GVL held would have blocked. */
+#define ZmqFastPathMissed(fast) (!(fast) || zmq_errno() == EAGAIN)
+
+/* Raises if a receive failed on a payload that wasn't framed by a compressing peer */
+#define ZmqRaiseNotFramed() \
+    rb_raise(rb_eZmqError, "received a payload not framed for compression - is compression enabled on both peers?")
+
+#define ZmqAssertDecompressed() \
+    if (zmq_errno() == EPROTO) ZmqRaiseNotFramed();
+
+#define ZmqStatsSent(sock, messages, bytes) \
+  do { \
+      (sock)->stats.messages_sent += (messages); \
+      (sock)->stats.bytes_sent += (bytes); \
+  } while(0)
+
+#define ZmqStatsReceived(sock, messages, bytes) \
+  do { \
+      (sock)->stats.messages_received += (messages); \
+      (sock)->stats.bytes_received += (bytes); \
+  } while(0)
+
+#define ZmqStatsError(sock) \
+  do { \
+      if (zmq_errno() == EAGAIN) (sock)->stats.eagain++; \
+      else if (zmq_errno() == EINTR) (sock)->stats.eintr++; \
+  } while(0)
+
 #define ZmqSockGuardCrossThread(sock) \
   if ((sock)->thread != rb_thread_current()) \
       rb_raise(rb_eZmqError, "Cross thread violation for %s socket %p: created in thread %p, invoked on thread %p", zsocket_type_str((sock)->socket), (void *)(sock), (void *)(sock)->thread, (void *)rb_thread_current());
@@ -95,6 +149,14 @@ typedef struct {
     if (!((sock)->state & (ZMQ_SOCKET_BOUND | ZMQ_SOCKET_CONNECTED))) \
         rb_raise(rb_eZmqError, msg);
 
+/* Sending, receiving, checking ZMQ_EVENTS, binding and connecting may process pending commands and consume the edge
+   of the ZMQ_FD, thus epoll backed pollers the socket is registered with have to check ZMQ_EVENTS again. */
+#define ZmqSocketTouched(sock) \
+    if ((sock)->registrations) rb_czmq_poller_socket_touched(sock);
+
+#define ZmqAssertNoDeferredRecvError(sock) \
+    if ((sock)->recv_error) rb_czmq_raise_deferred_recv_error(sock);
+
 void rb_czmq_free_sock(zmq_sock_wrapper *sock);
 
 void rb_czmq_mark_sock(void *ptr);
@@ -104,9 +166,16 @@ struct nogvl_send_args {
     zmq_sock_wrapper *socket;
     const char *msg;
     long length;
+    zmq_zero_copy_pin *pin; /* set if msg is sent without copying */
     bool read;
 };
 
+struct nogvl_sendv_args {
+    zmq_sock_wrapper *socket;
+    struct nogvl_send_args *parts;
+    long count;
+};
+
 struct nogvl_send_frame_args {
     zmq_sock_wrapper *socket;
     zframe_t *frame;
@@ -120,11 +189,39 @@ struct nogvl_send_message_args {
     bool read;
 };
 
+struct nogvl_send_msg_args {
+    zmq_sock_wrapper *socket;
+    zmq_msg_t message;
+    int flags;
+    bool compress; /* set if the message still needs to be framed for compression */
+};
+
 struct nogvl_recv_args {
     zmq_sock_wrapper *socket;
     zmq_msg_t message;
 };
 
+/* Frames received by batch receives while the GIL is released, thus allocated with the system allocator */
+typedef struct {
+    zmq_msg_t *frames;
+    char *more; /* more flags of frames, which decompression drops */
+    int *owners; /* tag of the receive each frame belongs to */
+    long nframes;
+    long capacity;
+    long messages;
+    int error; /* errno of a failed receive, other than EAGAIN */
+} zmq_recv_batch;
+
+#define ZMQ_RECV_BATCH_INITIAL_CAPA 64
+
+struct nogvl_recv_batch_args {
+    zmq_sock_wrapper *socket;
+    long max;
+    long timeout;
+    zmq_recv_batch batch;
+    VALUE result;
+};
+
 struct nogvl_socket_poll_args {
     zmq_sock_wrapper *socket;
     int timeout;
@@ -153,6 +250,33 @@ extern VALUE intern_on_closed;
 extern VALUE intern_on_close_failed;
 extern VALUE intern_on_disconnected;
 
+static inline uint64_t rb_czmq_monotonic_clock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+VALUE rb_czmq_socket_call_without_gvl(zmq_sock_wrapper *sock, int direction, void *(*func)(void *), void *args, bool defer_ints);
+#define ZmqCallWithoutGVL(sock, direction, func, args) \
+    rb_czmq_socket_call_without_gvl((sock), (direction), (func), (void *)(args), false)
+
+/* Doesn't raise pending interrupts once the GVL is reacquired, for callers that received messages without it to
+   build them first and check with rb_thread_check_ints after */
+#define ZmqCallWithoutGVLDeferInts(sock, direction, func, args) \
+    rb_czmq_socket_call_without_gvl((sock), (direction), (func), (void *)(args), true)
+
+/* Received messages smaller than this are always copied into a NUL terminated String, rather than viewed */
+#define ZMQ_MSG_VIEW_MIN_SIZE 4096
+
+VALUE rb_czmq_msg_str(zmq_msg_t *message);
+
+void rb_czmq_raise_deferred_recv_error(zmq_sock_wrapper *sock);
+void rb_czmq_recv_batch_init(zmq_recv_batch *batch);
+VALUE rb_czmq_recv_batch_free(VALUE ptr);
+long rb_czmq_recv_batch_drain(zmq_recv_batch *batch, zmq_sock_wrapper *sock, long max, int flags, int owner);
+VALUE rb_czmq_recv_batch_message(zmq_recv_batch *batch, long *frame);
+
 void _init_rb_czmq_socket();
 VALUE rb_czmq_nogvl_zsocket_destroy(void *ptr);
 
@@ -0,0 +1,229 @@
+#include "rbczmq_ext.h"
+
+zmq_trace_ring *rb_czmq_trace = NULL;
+
+/* Trace record as serialized by ZMQ::Trace.dump : timestamp, socket, size, op, captured bytes and the payload prefix,
+   in native byte order and without padding */
+#define ZMQ_TRACE_DUMP_RECORD_SIZE (8 + 8 + 4 + 2 + 2 + ZMQ_TRACE_CAPTURE)
+
+static const char *rb_czmq_trace_ops[] = {
+    "send", "sendm", "send_frame", "send_message", "recv", "recv_frame", "recv_message"
+};
+
+/*
+ * :nodoc:
+ *  Appends a record to the trace ring. Lock-free - concurrent writers claim distinct slots.
+ *
+*/
+void rb_czmq_trace_record(void *socket, int op, const void *data, size_t captured, size_t size)
+{
+    zmq_trace_ring *ring = rb_czmq_trace;
+    zmq_trace_record *record = NULL;
+    unsigned long seq;
+    if (!ring) return;
+    seq = ZmqAtomicIncrement(ring->cursor);
+    record = &ring->records[(seq - 1) & ring->mask];
+    record->seq = 0;
+    ZmqMemoryBarrier();
+    record->timestamp = rb_czmq_trace_clock();
+    record->socket = (uint64_t)(uintptr_t)socket;
+    record->size = (uint32_t)size;
+    record->op = (uint16_t)op;
+    if (captured > ZMQ_TRACE_CAPTURE) captured = ZMQ_TRACE_CAPTURE;
+    record->captured = (uint16_t)captured;
+    memcpy(record->payload, data, captured);
+    ZmqMemoryBarrier();
+    record->seq = seq;
+}
+
+/*
+ * :nodoc:
+ *  Releases the trace ring. Requires the GVL - all writers run with it held.
+ *
+*/
+static void rb_czmq_trace_free(zmq_trace_ring *ring)
+{
+    if (ring) {
+        xfree(ring->records);
+        xfree(ring);
+    }
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.enable(capacity = 4096)    =>  nil
+ *
+ *  Starts recording compact binary trace records for all socket sends and receives into a fixed size ring buffer of
+ *  at least the given number of records. Each record holds a timestamp, the socket, the operation, the payload size
+ *  and the first 32 payload bytes. The oldest records are overwritten once the buffer is full. Any previously
+ *  recorded trace is discarded.
+ *
+ * === Examples
+ *     ZMQ::Trace.enable           =>  nil
+ *     ZMQ::Trace.enable(65536)    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_trace_s_enable(int argc, VALUE *argv, ZMQ_UNUSED VALUE obj)
+{
+    VALUE capacity;
+    unsigned long size = 1;
+    long requested = ZMQ_TRACE_DEFAULT_CAPACITY;
+    zmq_trace_ring *ring = NULL;
+    rb_scan_args(argc, argv, "01", &capacity);
+    if (!NIL_P(capacity)) {
+        Check_Type(capacity, T_FIXNUM);
+        requested = FIX2LONG(capacity);
+        if (requested <= 0) rb_raise(rb_eArgError, "trace capacity must be positive!");
+    }
+    while (size < (unsigned long)requested) size <<= 1;
+    ring = ALLOC(zmq_trace_ring);
+    ring->records = ALLOC_N(zmq_trace_record, size);
+    MEMZERO(ring->records, zmq_trace_record, size);
+    ring->mask = size - 1;
+    ring->cursor = 0;
+    rb_czmq_trace_free(rb_czmq_trace);
+    rb_czmq_trace = ring;
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.disable    =>  nil
+ *
+ *  Stops tracing and discards all recorded trace records.
+ *
+ * === Examples
+ *     ZMQ::Trace.disable    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_trace_s_disable(ZMQ_UNUSED VALUE obj)
+{
+    zmq_trace_ring *ring = rb_czmq_trace;
+    rb_czmq_trace = NULL;
+    rb_czmq_trace_free(ring);
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.enabled?    =>  boolean
+ *
+ *  Determines if socket operations are currently being traced.
+ *
+ * === Examples
+ *     ZMQ::Trace.enabled?    =>  false
+ *
+*/
+
+static VALUE rb_czmq_trace_s_enabled_p(ZMQ_UNUSED VALUE obj)
+{
+    return rb_czmq_trace ? Qtrue : Qfalse;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.capacity    =>  Fixnum or nil
+ *
+ *  Returns the number of records the trace buffer holds, or nil if tracing is disabled.
+ *
+ * === Examples
+ *     ZMQ::Trace.enable(1000)
+ *     ZMQ::Trace.capacity    =>  1024
+ *
+*/
+
+static VALUE rb_czmq_trace_s_capacity(ZMQ_UNUSED VALUE obj)
+{
+    if (!rb_czmq_trace) return Qnil;
+    return ULONG2NUM(rb_czmq_trace->mask + 1);
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.clear    =>  nil
+ *
+ *  Discards all recorded trace records, leaving tracing enabled.
+ *
+ * === Examples
+ *     ZMQ::Trace.clear    =>  nil
+ *
+*/
+
+static VALUE rb_czmq_trace_s_clear(ZMQ_UNUSED VALUE obj)
+{
+    zmq_trace_ring *ring = rb_czmq_trace;
+    if (ring) {
+        MEMZERO(ring->records, zmq_trace_record, ring->mask + 1);
+        ring->cursor = 0;
+    }
+    return Qnil;
+}
+
+/*
+ *  call-seq:
+ *     ZMQ::Trace.dump    =>  String
+ *
+ *  Returns all trace records currently in the buffer, oldest first, as a binary String of fixed size records. Decode
+ *  them with ZMQ::Trace.decode, or use ZMQ::Trace.records to do both at once. Records that are being overwritten
+ *  while dumping are skipped.
+ *
+ * === Examples
+ *     ZMQ::Trace.dump    =>  String
+ *
+*/
+
+static VALUE rb_czmq_trace_s_dump(ZMQ_UNUSED VALUE obj)
+{
+    zmq_trace_ring *ring = rb_czmq_trace;
+    zmq_trace_record record;
+    unsigned long cursor, seq;
+    VALUE dump;
+    char *ptr = NULL;
+    long len = 0;
+    if (!ring) return ZmqEncode(rb_str_new(0, 0));
+    cursor = ring->cursor;
+    seq = cursor > ring->mask ? cursor - ring->mask : 1;
+    dump = rb_str_new(0, (cursor - seq + 1) * ZMQ_TRACE_DUMP_RECORD_SIZE);
+    ptr = RSTRING_PTR(dump);
+    for (; seq <= cursor; seq++) {
+        zmq_trace_record *slot = &ring->records[(seq - 1) & ring->mask];
+        if (slot->seq != seq) continue;
+        ZmqMemoryBarrier();
+        memcpy(&record, slot, sizeof(zmq_trace_record));
+        ZmqMemoryBarrier();
+        if (slot->seq != seq) continue;
+        memcpy(ptr + len, &record.timestamp, 8);
+        memcpy(ptr + len + 8, &record.socket, 8);
+        memcpy(ptr + len + 16, &record.size, 4);
+        memcpy(ptr + len + 20, &record.op, 2);
+        memcpy(ptr + len + 22, &record.captured, 2);
+        memcpy(ptr + len + 24, record.payload, ZMQ_TRACE_CAPTURE);
+        len += ZMQ_TRACE_DUMP_RECORD_SIZE;
+    }
+    rb_str_set_len(dump, len);
+    return ZmqEncode(dump);
+}
+
+void _init_rb_czmq_trace()
+{
+    int op;
+    VALUE ops = rb_ary_new();
+    for (op = 0; op < (int)(sizeof(rb_czmq_trace_ops) / sizeof(char *)); op++)
+        rb_ary_push(ops, ID2SYM(rb_intern(rb_czmq_trace_ops[op])));
+    rb_obj_freeze(ops);
+
+    rb_mZmqTrace = rb_define_module_under(rb_mZmq, "Trace");
+
+    rb_define_const(rb_mZmqTrace, "OPS", ops);
+    rb_define_const(rb_mZmqTrace, "CAPTURE", INT2NUM(ZMQ_TRACE_CAPTURE));
+    rb_define_const(rb_mZmqTrace, "RECORD_SIZE", INT2NUM(ZMQ_TRACE_DUMP_RECORD_SIZE));
+
+    rb_define_module_function(rb_mZmqTrace, "enable", rb_czmq_trace_s_enable, -1);
+    rb_define_module_function(rb_mZmqTrace, "disable", rb_czmq_trace_s_disable, 0);
+    rb_define_module_function(rb_mZmqTrace, "enabled?", rb_czmq_trace_s_enabled_p, 0);
+    rb_define_module_function(rb_mZmqTrace, "capacity", rb_czmq_trace_s_capacity, 0);
+    rb_define_module_function(rb_mZmqTrace, "clear", rb_czmq_trace_s_clear, 0);
+    rb_define_module_function(rb_mZmqTrace, "dump", rb_czmq_trace_s_dump, 0);
+}
@@ -0,0 +1,90 @@
+#ifndef RBCZMQ_TRACE_H
+#define RBCZMQ_TRACE_H
+
+/* Number of leading payload bytes captured per trace record */
+#define ZMQ_TRACE_CAPTURE 32
+#define ZMQ_TRACE_DEFAULT_CAPACITY 4096
+
+/* Traced socket operations - indexes into ZMQ::Trace::OPS */
+#define ZMQ_TRACE_SEND 0
+#define ZMQ_TRACE_SENDM 1
+#define ZMQ_TRACE_SEND_FRAME 2
+#define ZMQ_TRACE_SEND_MESSAGE 3
+#define ZMQ_TRACE_RECV 4
+#define ZMQ_TRACE_RECV_FRAME 5
+#define ZMQ_TRACE_RECV_MESSAGE 6
+
+/* A fixed size binary record. The sequence number is cleared while a writer fills the slot and set once it's done,
+   which lets readers detect and skip records that are concurrently being written or overwritten. */
+typedef struct {
+    volatile unsigned long seq;
+    uint64_t timestamp;
+    uint64_t socket;
+    uint32_t size;
+    uint16_t op;
+    uint16_t captured;
+    unsigned char payload[ZMQ_TRACE_CAPTURE];
+} zmq_trace_record;
+
+/* Writers claim slots with an atomic increment of the cursor and never block - the oldest records are overwritten
+   once the ring wraps around. The capacity is a power of 2. */
+typedef struct {
+    zmq_trace_record *records;
+    unsigned long mask;
+    volatile unsigned long cursor;
+} zmq_trace_ring;
+
+extern zmq_trace_ring *rb_czmq_trace;
+
+/* Payload prefix of a frame or message captured before a send hands it over to libzmq */
+typedef struct {
+    bool traced;
+    size_t size;
+    size_t captured;
+    unsigned char payload[ZMQ_TRACE_CAPTURE];
+} zmq_trace_capture;
+
+#define ZmqTrace(sock, op, data, size) \
+  do { \
+      if (rb_czmq_trace) rb_czmq_trace_record((sock)->socket, (op), (data), (size), (size)); \
+  } while(0)
+
+#define ZmqTraceCapture(capture, data, length, total) \
+  do { \
+      (capture).traced = (rb_czmq_trace != NULL); \
+      if ((capture).traced) { \
+          (capture).size = (total); \
+          (capture).captured = (length) < ZMQ_TRACE_CAPTURE ? (length) : ZMQ_TRACE_CAPTURE; \
+          memcpy((capture).payload, (data), (capture).captured); \
+      } \
+  } while(0)
+
+/* Captures the head of the first frame and the content size of a message */
+#define ZmqTraceCaptureMessage(capture, message) \
+  do { \
+      zframe_t *head = zmsg_first(message); \
+      if (head) { \
+          ZmqTraceCapture(capture, zframe_data(head), zframe_size(head), zmsg_content_size(message)); \
+      } else { \
+          (capture).traced = false; \
+      } \
+  } while(0)
+
+#define ZmqTraceCaptured(sock, op, capture) \
+  do { \
+      if ((capture).traced && rb_czmq_trace) \
+          rb_czmq_trace_record((sock)->socket, (op), (capture).payload, (capture).captured, (capture).size); \
+  } while(0)
+
+static inline uint64_t rb_czmq_trace_clock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void rb_czmq_trace_record(void *socket, int op, const void *data, size_t captured, size_t size);
+
+void _init_rb_czmq_trace();
+
+#endif
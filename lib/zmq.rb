@@ -34,9 +34,10 @@ module ZMQ
   # Sugaring for creating new poll items
   #
   # ZMQ::Pollitem(STDIN, ZMQ::POLLIN)  =>  ZMQ::Pollitem
+  # ZMQ::Pollitem(sock, ZMQ::POLLIN, priority: 0, weight: 4)  =>  ZMQ::Pollitem
   #
-  def self.Pollitem(pollable, events = nil)
-    ZMQ::Pollitem.new(pollable, events)
+  def self.Pollitem(pollable, events = nil, options = nil)
+    ZMQ::Pollitem.new(pollable, events, options)
   end
 
   # Returns the ZMQ context for this process, if any
@@ -84,3 +85,5 @@ require "zmq/message"
 require "zmq/poller"
 require "zmq/pollitem"
 require "zmq/logger"
+require "zmq/trace"
+require "zmq/histogram"
@@ -0,0 +1,40 @@
+# encoding: utf-8
+
+class ZMQ::Histogram
+
+  # The ZMQ::Histogram class is a compact log-linear histogram of latencies in nanoseconds. Sockets record the time
+  # spent blocked in every send and receive that releases the GVL - see ZMQ::Socket#send_latency and
+  # ZMQ::Socket#recv_latency.
+
+  # Median latency in nanoseconds
+  #
+  def p50
+    percentile(50)
+  end
+
+  # 99th percentile latency in nanoseconds
+  #
+  def p99
+    percentile(99)
+  end
+
+  # 99.9th percentile latency in nanoseconds
+  #
+  def p999
+    percentile(99.9)
+  end
+
+  # Returns a new histogram with the values of this and another histogram.
+  #
+  # total = sock1.recv_latency.merge(sock2.recv_latency)
+  #
+  def merge(other)
+    dup.merge!(other)
+  end
+
+  # Returns a Hash summary of this histogram
+  #
+  def to_h
+    { :count => count, :min => min, :max => max, :mean => mean, :p50 => p50, :p99 => p99, :p999 => p999 }
+  end
+end
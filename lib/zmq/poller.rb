@@ -8,6 +8,15 @@ class ZMQ::Poller
     poll(0)
   end
 
+  # API sugar to poll and yield each ready socket or IO along with its ready events, without building the readables
+  # and writables arrays. Returns the number of items in a ready state.
+  #
+  def poll_each(timeout = 0, &block)
+    rc = poll(timeout)
+    each_ready(&block) if rc > 0
+    rc
+  end
+
   # API sugar for registering a ZMQ::Socket or IO for readability
   #
   def register_readable(pollable)
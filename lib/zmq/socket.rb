@@ -171,12 +171,14 @@ module ZMQ::DownstreamSocket
   #
   # === Behavior
   #
-  # [Disabled methods] ZMQ::Socket#bind, ZMQ::Socket#send, ZMQ::Socket#sendm, ZMQ::Socket#send_frame,
-  #                    ZMQ::Socket#send_message
+  # [Disabled methods] ZMQ::Socket#bind, ZMQ::Socket#send, ZMQ::Socket#send_nonblock, ZMQ::Socket#sendm,
+  #                    ZMQ::Socket#sendm_nonblock, ZMQ::Socket#sendv, ZMQ::Socket#send_frame,
+  #                    ZMQ::Socket#send_frame_nonblock, ZMQ::Socket#send_message, ZMQ::Socket#send_message_nonblock,
+  #                    ZMQ::Socket#send_packed
   # [Socket types] ZMQ::Socket::Pull, ZMQ::Socket::Sub
 
   def self.included(sock)
-    sock.unsupported_api :send, :sendm, :send_frame, :send_message
+    sock.unsupported_api :send, :sendm, :sendv, :send_nonblock, :sendm_nonblock, :send_frame, :send_frame_nonblock, :send_message, :send_message_nonblock, :send_packed
   end
 
   # Upstream sockets should never be polled for writable states
@@ -190,12 +192,13 @@ module ZMQ::UpstreamSocket
   #
   # === Behavior
   #
-  # [Disabled methods] ZMQ::Socket#connect, ZMQ::Socket#recv, ZMQ::Socket#recv_nonblock, ZMQ::Socket#recv_frame,
-  #                    ZMQ::Socket#recv_frame_nonblock, ZMQ::Socket#recv_message
+  # [Disabled methods] ZMQ::Socket#connect, ZMQ::Socket#recv, ZMQ::Socket#recv_nonblock, ZMQ::Socket#recv_into,
+  #                    ZMQ::Socket#recv_into_nonblock, ZMQ::Socket#recv_batch, ZMQ::Socket#recv_frame,
+  #                    ZMQ::Socket#recv_frame_nonblock, ZMQ::Socket#recv_message, ZMQ::Socket#recv_unpacked
   # [Socket types] ZMQ::Socket::Push, ZMQ::Socket::Pub
 
   def self.included(sock)
-    sock.unsupported_api :recv, :recv_nonblock, :recv_frame, :recv_frame_nonblock, :recv_message
+    sock.unsupported_api :recv, :recv_nonblock, :recv_into, :recv_into_nonblock, :recv_batch, :recv_frame, :recv_frame_nonblock, :recv_message, :recv_unpacked
   end
 
   # Upstream sockets should never be polled for readable states
@@ -27,11 +27,16 @@ class ZMQ::Socket::Rep
     ZMQ::REP
   end
 
-  unsupported_api :sendm
-  handle_fsm_errors "REP sockets allows only an alternating sequence of receive and subsequent send calls.", :send, :send_frame, :send_message, :recv, :recv_nonblock, :recv_frame, :recv_frame_nonblock, :recv_message
+  unsupported_api :sendm, :sendm_nonblock
+  handle_fsm_errors "REP sockets allows only an alternating sequence of receive and subsequent send calls.", :send, :send_nonblock, :sendv, :send_frame, :send_frame_nonblock, :send_message, :send_message_nonblock, :send_packed, :recv, :recv_nonblock, :recv_into, :recv_into_nonblock, :recv_batch, :recv_frame, :recv_frame_nonblock, :recv_message, :recv_unpacked
 
   def send_frame(frame, flags = 0)
     raise ZMQ::Error, "cannot send multiple frames on REP sockets" if (flags & ZMQ::Frame::MORE) == ZMQ::Frame::MORE
     super
   end
+
+  def send_frame_nonblock(frame, flags = 0)
+    raise ZMQ::Error, "cannot send multiple frames on REP sockets" if (flags & ZMQ::Frame::MORE) == ZMQ::Frame::MORE
+    super
+  end
 end
\ No newline at end of file
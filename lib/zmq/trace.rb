@@ -0,0 +1,30 @@
+# encoding: utf-8
+
+module ZMQ::Trace
+
+  # The ZMQ::Trace module records compact binary trace records for socket sends and receives into a fixed size, lock-free
+  # ring buffer. Unlike verbose sockets, nothing is copied or formatted beyond the first CAPTURE payload bytes, thus
+  # tracing can be left enabled in production and the buffer dumped on demand.
+  #
+  #   ZMQ::Trace.enable
+  #   ...
+  #   ZMQ::Trace.records.each{|r| p r }
+
+  Record = Struct.new(:timestamp, :socket, :op, :size, :payload)
+
+  # Decodes a binary trace dump as returned by ZMQ::Trace.dump into an Array of ZMQ::Trace::Record instances. Timestamps
+  # are nanoseconds since the epoch and sockets are identified by their native socket address.
+  #
+  def self.decode(dump)
+    fields = dump.unpack("QQLSSa#{CAPTURE}" * (dump.bytesize / RECORD_SIZE))
+    fields.each_slice(6).map do |timestamp, socket, size, op, captured, payload|
+      Record.new(timestamp, socket, OPS[op], size, payload[0, captured])
+    end
+  end
+
+  # Returns all trace records currently in the buffer, oldest first.
+  #
+  def self.records
+    decode(dump)
+  end
+end
@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 pair = ctx.socket(:PAIR)
+pair.fast_path = $runner.fast_path
 sleep 2
 pair.connect($runner.endpoint)
 
@@ -2,6 +2,7 @@
 
 ctx = ZMQ.context
 pair = ctx.socket(:PAIR);
+pair.fast_path = $runner.fast_path
 pair.bind($runner.endpoint);
 
 msg = $runner.payload
@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 sub = ctx.socket(:SUB)
+sub.fast_path = $runner.fast_path
 sub.subscribe("")
 sub.connect($runner.endpoint)
 
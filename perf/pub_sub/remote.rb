@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 pub = ctx.socket(:PUB);
+pub.fast_path = $runner.fast_path
 pub.bind($runner.endpoint);
 
 msg = $runner.payload
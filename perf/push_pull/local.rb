@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 pull = ctx.socket(:PULL)
+pull.fast_path = $runner.fast_path
 pull.connect($runner.endpoint)
 
 messages, start_time = 0, nil
@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 push = ctx.socket(:PUSH);
+push.fast_path = $runner.fast_path
 push.bind($runner.endpoint);
 
 msg = $runner.payload
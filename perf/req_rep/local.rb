@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 req = ctx.socket(:REQ)
+req.fast_path = $runner.fast_path
 req.connect($runner.endpoint)
 
 msg = $runner.payload
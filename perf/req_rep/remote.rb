@@ -2,6 +2,7 @@
 
 ctx = ZMQ::Context.new
 rep = ctx.socket(:REP);
+rep.fast_path = $runner.fast_path
 rep.bind($runner.endpoint);
 
 start_time = Time.now
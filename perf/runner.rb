@@ -8,13 +8,14 @@ class Runner
   DEFAULT_MSG_SIZE = 100
   DEFAULT_ENCODING = :string
 
-  attr_reader :msg_count, :msg_size, :encoding, :workers_count, :stats_buf
+  attr_reader :msg_count, :msg_size, :encoding, :workers_count, :fast_path, :stats_buf
 
   def initialize(msg_count, msg_size, encoding, workers_count = 1)
     @msg_count = (msg_count || DEFAULT_MSG_COUNT).to_i
     @msg_size = (msg_size || DEFAULT_MSG_SIZE).to_i
     @encoding = (encoding || DEFAULT_ENCODING).to_sym
     @workers_count = (workers_count || 1).to_i
+    @fast_path = ENV["FAST_PATH"] != "0"
     @stats_buf, @workers = [], []
     register_signal_handlers
   end
@@ -50,6 +51,7 @@ class Runner
     megabits = throughput * msg_size * 8 / 1000000
     stats_buf << "====== [#{Process.pid}] transfer stats ======"
     stats_buf << "message encoding: %s" % encoding
+    stats_buf << "fast path: %s" % (fast_path ? "enabled" : "disabled")
     stats_buf << "message size: %i [B]" % msg_size
     stats_buf << "message count: %i" % process_msg_count
     stats_buf << "mean throughput: %i [msg/s]" % throughput
@@ -21,6 +21,12 @@ class TestReqSocket < ZmqTestCase
     assert_raises ZMQ::Error do
       sock.send_frame(ZMQ::Frame("frame"), ZMQ::Frame::MORE)
     end
+    assert_raises ZMQ::Error do
+      sock.send_frame_nonblock(ZMQ::Frame("frame"), ZMQ::Frame::MORE)
+    end
+    assert_raises ZMQ::Error do
+      sock.sendm_nonblock("part")
+    end
   ensure
     ctx.destroy
   end
@@ -59,6 +59,35 @@ class TestZmqContext < ZmqTestCase
     ctx.destroy
   end
 
+  def test_buffer_pool
+    ctx = ZMQ::Context.new
+    assert_nil ctx.buffer_pool
+    assert_raises ArgumentError do
+      ctx.buffer_pool = {:max_size => 16}
+    end
+    ctx.buffer_pool = {:max_size => 4096, :hugepages => true}
+    assert_equal 4096, ctx.buffer_pool[:max_size]
+    assert ctx.buffer_pool[:hugepages]
+    pull = ctx.socket(:PULL)
+    port = pull.bind("tcp://127.0.0.1:*")
+    push = ctx.connect(:PUSH, "tcp://127.0.0.1:#{port}")
+    payload = "x" * 1000
+    100.times do
+      push.send(payload)
+      assert_equal payload, pull.recv
+    end
+    push.send("x" * 8192)
+    assert_equal 8192, pull.recv.size
+    stats = ctx.buffer_pool
+    assert_equal 100, stats[:hits] + stats[:misses]
+    assert stats[:hits] > 0
+    assert stats[:reserved] > 0
+    ctx.buffer_pool = nil
+    assert_nil ctx.buffer_pool
+  ensure
+    ctx.destroy
+  end
+
   def test_bind_connect
     ctx = ZMQ::Context.new
     rep = ctx.bind(:REP, "inproc://test.bind_connect")
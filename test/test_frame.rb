@@ -33,6 +33,20 @@ class TestZmqFrame < ZmqTestCase
     assert_equal "message", frame.to_str
   end
 
+  def test_zero_copy
+    ZMQ.zero_copy_threshold = 0
+    payload = ("x" * 65536).freeze
+    frame = ZMQ::Frame(payload)
+    GC.start
+    assert_equal payload.size, frame.size
+    assert_equal payload, frame.data
+    frame.reset("new")
+    assert_equal "new", frame.data
+    assert_equal "", ZMQ::Frame("".freeze).data
+  ensure
+    ZMQ.zero_copy_threshold = nil
+  end
+
   def test_dup
     frame =  ZMQ::Frame("message")
     dup_frame = frame.dup
@@ -57,6 +71,15 @@ class TestZmqFrame < ZmqTestCase
     assert_operator frame, :!=, ZMQ::Frame("msg")
   end
 
+  def test_hash
+    frame = ZMQ::Frame("message")
+    assert_equal frame.hash, ZMQ::Frame("message").hash
+    assert frame.hash != ZMQ::Frame("messagf").hash
+    cache = { frame => 1 }
+    assert_equal 1, cache[ZMQ::Frame("message")]
+    assert_nil cache[ZMQ::Frame("msg")]
+  end
+
   def test_compare
     frame =  ZMQ::Frame("message")
     assert frame > ZMQ::Frame("msg")
@@ -74,4 +97,118 @@ class TestZmqFrame < ZmqTestCase
     frame.reset("msg")
     assert_equal "msg", frame.data
   end
+
+  def test_slice
+    frame = ZMQ::Frame("headerbody")
+    body = frame.slice(6, 4)
+    assert_instance_of ZMQ::Frame, body
+    assert_equal "body", body.to_s
+    assert_equal "head", frame.slice(0, 4).data
+    assert_equal "dy", frame.slice(-2, 10).data
+    assert_equal "er", frame.slice(4, 2).data
+    assert_nil body.slice(-10, 2)
+    assert_equal "", frame.slice(10, 1).data
+    assert_equal "", ZMQ::Frame("").slice(0, 5).data
+    assert_nil frame.slice(11, 1)
+    assert_nil frame.slice(0, -1)
+    assert_equal "headerbody", frame.data
+    frame.destroy
+    assert_equal "body", body.data
+    assert_equal "od", body.slice(1, 2).data
+  end
+
+  def test_send_slice
+    ctx = ZMQ::Context.new
+    pull = ctx.socket(:PULL)
+    port = pull.bind("tcp://127.0.0.1:*")
+    push = ctx.connect(:PUSH, "tcp://127.0.0.1:#{port}")
+    msg = ZMQ::Message("id", "headerbody")
+    frame = msg.last
+    body = frame.slice(6, 4)
+    assert_equal "headerbody", msg[1].data
+    push.send_message(msg)
+    push.send_frame(body)
+    received = pull.recv_message
+    assert_equal %w(id headerbody), received.to_a.map(&:data)
+    assert_equal "body", pull.recv
+  ensure
+    ctx.destroy
+  end
+
+  def test_typed_readers
+    frame = ZMQ::Frame([42, -2, 0x0102030405060708, 1.5, 2.25, 255].pack("NnQ>gEC"))
+    assert_equal 42, frame.read_u32be(0)
+    assert_equal 0x2A000000, frame.read_u32le(0)
+    assert_equal 65534, frame.read_u16be(4)
+    assert_equal(-2, frame.read_i16be(4))
+    assert_equal 0x0102030405060708, frame.read_u64be(6)
+    assert_equal 0x0807060504030201, frame.read_u64le(6)
+    assert_equal 1.5, frame.read_f32be(14)
+    assert_equal 2.25, frame.read_f64le(18)
+    assert_equal 255, frame.read_u8(26)
+    assert_equal(-1, frame.read_i8(26))
+    assert_raises IndexError do
+      frame.read_u16be(26)
+    end
+    assert_raises IndexError do
+      frame.read_u8(-1)
+    end
+  end
+
+  def test_typed_writers
+    frame = ZMQ::Frame("\0" * 16)
+    frame.write_u32be(0, 0xDEADBEEF)
+    frame.write_i16le(4, -3)
+    frame.write_f64be(8, -0.5)
+    assert_equal [0xDEADBEEF, -3, -0.5], frame.data.unpack("Ns<x2G")
+    assert_raises IndexError do
+      frame.write_u64le(9, 1)
+    end
+    assert_raises ZMQ::Error do
+      frame.slice(0, 4).write_u8(0, 1)
+    end
+  end
+
+  def test_build
+    frame = ZMQ::Frame.build do |b|
+      assert_equal b, b.u64(7)
+      b.u16le(2).i8(-1)
+      b.f32(0.5)
+      b.bytes("payload")
+      assert_equal 22, b.size
+    end
+    assert_instance_of ZMQ::Frame, frame
+    assert_equal [7, 2, -1, 0.5, "payload"], frame.data.unpack("Q>vcga*")
+    assert_equal 7, frame.read_u64be(0)
+    assert_equal "", ZMQ::Frame.build { }.data
+  end
+
+  def test_numeric_arrays
+    frame = ZMQ::Frame.from_doubles([1.5, -2, 4.25])
+    assert_equal 24, frame.size
+    assert_equal [1.5, -2.0, 4.25], frame.data.unpack("E*")
+    assert_equal [1.5, -2.0, 4.25], frame.to_doubles
+    frame = ZMQ::Frame.from_int64s([1, -2, 2**62])
+    assert_equal [1, -2, 2**62], frame.data.unpack("q<*")
+    assert_equal [1, -2, 2**62], frame.to_int64s
+    assert_equal [], ZMQ::Frame.from_doubles([]).to_doubles
+    assert_raises(TypeError){ ZMQ::Frame.from_doubles(["a"]) }
+    assert_raises(ArgumentError){ ZMQ::Frame("odd").to_doubles }
+    array = [1.5]
+    shrinking = Class.new(Numeric){ define_method(:to_f){ array.clear; 2.0 } }.new
+    array.unshift(shrinking)
+    assert_raises(RuntimeError){ ZMQ::Frame.from_doubles(array) }
+  end
+
+  def test_numeric_kernels
+    frame = ZMQ::Frame.from_doubles([1.5, -2.0, 4.0, 0.5, 3.0])
+    assert_equal 7.0, frame.sum
+    assert_equal [-2.0, 4.0], frame.minmax
+    frame = ZMQ::Frame.from_int64s([3, -7, 2**62, 2**62])
+    assert_equal 2**63 - 4, frame.sum(:int64)
+    assert_equal [-7, 2**62], frame.minmax(:int64)
+    assert_equal 0.0, ZMQ::Frame.new.sum
+    assert_equal [nil, nil], ZMQ::Frame.new.minmax(:int64)
+    assert_raises(ArgumentError){ frame.sum(:int32) }
+  end
 end
@@ -0,0 +1,50 @@
+# encoding: utf-8
+
+require File.expand_path("../helper.rb", __FILE__)
+
+class TestZmqHistogram < ZmqTestCase
+  def test_empty
+    histogram = ZMQ::Histogram.new
+    assert_equal 0, histogram.count
+    assert_nil histogram.min
+    assert_nil histogram.max
+    assert_nil histogram.mean
+    assert_nil histogram.p50
+  end
+
+  def test_record
+    histogram = ZMQ::Histogram.new
+    (1..1000).each{|i| histogram.record(i * 1000) }
+    assert_equal 1000, histogram.count
+    assert_equal 1000, histogram.min
+    assert_equal 1_000_000, histogram.max
+    assert_equal 500_500.0, histogram.mean
+    assert_in_delta 500_000, histogram.p50, 500_000 / 16
+    assert_in_delta 990_000, histogram.p99, 990_000 / 16
+    assert_equal 1_000_000, histogram.percentile(100)
+    assert_equal 1000, histogram.percentile(0)
+    assert_raises ArgumentError do
+      histogram.percentile(101)
+    end
+    assert_raises ArgumentError do
+      histogram.record(-1)
+    end
+    histogram.reset
+    assert_equal 0, histogram.count
+  end
+
+  def test_merge
+    a = ZMQ::Histogram.new
+    b = ZMQ::Histogram.new
+    a.record(10)
+    b.record(2000)
+    merged = a.merge(b)
+    assert_equal 1, a.count
+    assert_equal 2, merged.count
+    assert_equal 10, merged.min
+    assert_equal 2000, merged.max
+    assert_equal merged, merged.merge!(ZMQ::Histogram.new)
+    assert_equal 2, merged.count
+    assert_equal [:count, :min, :max, :mean, :p50, :p99, :p999], merged.to_h.keys
+  end
+end
@@ -182,6 +182,45 @@ class TestZmqMessage < ZmqTestCase
     assert_nil ZMQ::Message.decode("tainted")
   end
 
+  def test_encode_decode_large_frames
+    body = "x" * 1000
+    buffer = ZMQ::Message("header", body).encode
+    assert_equal "\006header\377\000\000\003\350" + body, buffer
+    decoded = ZMQ::Message.decode(buffer)
+    buffer.replace("changed")
+    assert_equal "header", decoded.popstr
+    assert_equal body, decoded.first.data
+    assert_nil ZMQ::Message.decode("\377\000\000\003\350" + "x" * 999)
+  end
+
+  def test_decode_zero_copy_threshold
+    body = "x" * 1000
+    buffer = ZMQ::Message("header", body).encode.freeze
+    [0, 4096].each do |threshold|
+      ZMQ.zero_copy_threshold = threshold
+      decoded = ZMQ::Message.decode(buffer)
+      GC.start
+      assert_equal "header", decoded.popstr
+      assert_equal body, decoded.first.data
+    end
+  ensure
+    ZMQ.zero_copy_threshold = nil
+  end
+
+  def test_encode_decode_many
+    messages = [ZMQ::Message("a"), ZMQ::Message("b", "x" * 300), ZMQ::Message.new]
+    buffer = ZMQ::Message.encode_many(messages)
+    assert_equal "\000\000\000\002\001a", buffer[0, 6]
+    decoded = ZMQ::Message.decode_many(buffer)
+    assert_equal 3, decoded.size
+    assert_equal messages, decoded
+    assert_equal [], ZMQ::Message.decode_many("")
+    assert_nil ZMQ::Message.decode_many(buffer[0..-2])
+    assert_raises TypeError do
+      ZMQ::Message.encode_many(["a"])
+    end
+  end
+
   def test_equals
     msg = ZMQ::Message.new
     msg.pushstr "body"
@@ -200,6 +239,24 @@ class TestZmqMessage < ZmqTestCase
     assert other.eql?(other)
   end
 
+  def test_equals_binary
+    msg = ZMQ::Message("\0a", "b\0c")
+    assert_equal msg, ZMQ::Message("\0a", "b\0c")
+    assert_operator msg, :!=, ZMQ::Message("\0b", "b\0c")
+    assert_operator msg, :!=, ZMQ::Message("\0a", "b\0d")
+    assert_operator msg, :!=, ZMQ::Message("\0ab", "\0c")
+  end
+
+  def test_hash
+    msg = ZMQ::Message("header", "body")
+    assert_equal msg.hash, ZMQ::Message("header", "body").hash
+    assert msg.hash != ZMQ::Message("head", "erbody").hash
+    assert msg.hash != ZMQ::Message("body", "header").hash
+    cache = { msg => :seen }
+    assert_equal :seen, cache[ZMQ::Message("header", "body")]
+    assert_nil cache[ZMQ::Message("header")]
+  end
+
   def test_message_with_frames
     msg = ZMQ::Message.new
     frame = ZMQ::Frame.new("hello")
@@ -301,4 +358,41 @@ class TestZmqMessage < ZmqTestCase
     assert_equal 1, other.size
   end
 
+  def test_lazy_frames
+    msg = ZMQ::Message.decode(ZMQ::Message("a", "b", "c").encode)
+    assert_equal "a", msg.popstr
+    frame = msg.first
+    assert_equal "b", frame.data
+    assert_equal frame.object_id, msg.first.object_id
+    msg.addstr "d"
+    assert_equal %w(b c d), msg.to_a.map(&:data)
+    assert_equal "b", msg.pop.data
+    assert_equal 2, msg.size
+  end
+
+  def test_frame_at
+    msg = ZMQ::Message(*(0...64).map { |i| "frame #{i}" })
+    assert_equal "frame 0", msg[0].data
+    assert_equal "frame 42", msg.at(42).data
+    assert_equal "frame 63", msg[-1].data
+    assert_equal msg[42].object_id, msg.to_a[42].object_id
+    assert_nil msg[64]
+    assert_nil msg[-65]
+    frame = ZMQ::Frame("head")
+    msg.push frame
+    assert_equal frame.object_id, msg[0].object_id
+    assert_equal "frame 42", msg[43].data
+  end
+
+  def test_each_frame
+    msg = ZMQ::Message("a", "b", "c")
+    assert_equal "a", msg.first.data
+    frames = []
+    assert_equal msg, msg.each_frame { |frame| frames << frame.data }
+    assert_equal %w(a b c), frames
+    GC.start
+    assert_equal "b", msg.next.data
+    assert_equal %w(a b c), msg.each_frame.map(&:data)
+  end
+
 end
@@ -1,6 +1,7 @@
 # encoding: utf-8
 
 require File.expand_path("../helper.rb", __FILE__)
+require 'timeout'
 
 class TestZmqPoller < ZmqTestCase
 
@@ -68,6 +69,159 @@ class TestZmqPoller < ZmqTestCase
     assert_equal "message", r.read(7)
   end
 
+  def test_poll_each
+    poller = ZMQ::Poller.new
+    r, w = IO.pipe
+    poller.register(ZMQ::Pollitem(r, ZMQ::POLLIN))
+    poller.register(ZMQ::Pollitem(w, ZMQ::POLLOUT))
+    w.write("message")
+    sleep 0.2
+
+    ready = {}
+    assert_equal 2, poller.poll_each(1) { |pollable, events| ready[pollable] = events }
+    assert_equal({r => ZMQ::POLLIN, w => ZMQ::POLLOUT}, ready)
+
+    assert_raises ZMQ::Error do
+      poller.each_ready { poller.poll }
+    end
+
+    yielded = []
+    poller.each_ready { |pollable, events| yielded << pollable; poller.remove(w) }
+    assert_equal 1, yielded.size
+    assert_equal [r], poller.readables
+    assert_equal [], poller.writables
+  ensure
+    r.close if r
+    w.close if w
+  end
+
+  def test_poll_interrupted
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new
+    rep = ctx.socket(:REP)
+    rep.linger = 0
+    rep.bind("inproc://test.poll-interrupted")
+    req = ctx.socket(:REQ)
+    req.linger = 0
+    req.connect("inproc://test.poll-interrupted")
+    assert poller.register_readable(rep)
+
+    assert_raises Timeout::Error do
+      Timeout.timeout(0.1){ poller.poll(-1) }
+    end
+
+    assert req.send("request")
+    assert_equal 1, poller.poll(1)
+    assert_equal [rep], poller.readables
+    assert poller.remove(rep)
+  ensure
+    ctx.destroy
+  end
+
+  def test_poll_recv_interrupted
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new
+    pull = ctx.socket(:PULL)
+    pull.linger = 0
+    pull.bind("inproc://test.poll-recv-interrupted")
+    push = ctx.socket(:PUSH)
+    push.linger = 0
+    push.connect("inproc://test.poll-recv-interrupted")
+    assert poller.register_readable(pull)
+
+    assert_raises Timeout::Error do
+      Timeout.timeout(0.1){ poller.poll_recv(-1) }
+    end
+    assert_raises Timeout::Error do
+      Timeout.timeout(0.1){ pull.recv_batch(10) }
+    end
+
+    assert push.send("message")
+    assert_equal [[pull, "message"]], poller.poll_recv(1)
+  ensure
+    ctx.destroy
+  end
+
+  def test_poll_recv
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new
+    pulls = (1..2).map do |i|
+      pull = ctx.socket(:PULL)
+      pull.linger = 0
+      pull.bind("inproc://test.poll_recv.#{i}")
+      poller.register_readable(pull)
+      pull
+    end
+    pushes = pulls.each_with_index.map do |_, i|
+      push = ctx.socket(:PUSH)
+      push.linger = 0
+      push.connect("inproc://test.poll_recv.#{i + 1}")
+      push
+    end
+    assert_equal [], poller.poll_recv(0)
+
+    3.times { |i| pushes[0].send("a#{i}") }
+    pushes[1].sendm("multi")
+    pushes[1].send("part")
+    sleep 0.1
+
+    received = poller.poll_recv(1, 2)
+    assert_equal 3, received.size
+    assert_equal [[pulls[0], "a0"], [pulls[0], "a1"]], received.select { |s, _| s == pulls[0] }
+    assert_equal [[pulls[1], ["multi", "part"]]], received.select { |s, _| s == pulls[1] }
+
+    assert_equal [[pulls[0], "a2"]], poller.poll_recv(1, 2)
+    assert_raises ArgumentError do
+      poller.poll_recv(1, 0)
+    end
+
+    # a socket dropping a message doesn't lose those received from others - its error is raised by the next call
+    pulls[1].compression = true
+    pushes[0].send("a3")
+    pushes[1].send("unframed")
+    sleep 0.1
+    assert_equal [[pulls[0], "a3"]], poller.poll_recv(1, 2)
+    assert_raises(ZMQ::Error){ poller.poll_recv(0) }
+    assert_equal [], poller.poll_recv(0)
+
+    # sockets may only be received from by the thread that created them
+    pushes[0].send("a4")
+    sleep 0.1
+    assert_raises(ZMQ::Error){ Thread.new { poller.poll_recv(1) }.value }
+    assert_equal [[pulls[0], "a4"]], poller.poll_recv(1)
+  ensure
+    ctx.destroy
+  end
+
+  def test_priority_polling
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new
+    socks = {}
+    [[:bulk, 1, 2], [:control, 0, 1]].each do |name, priority, weight|
+      pull = ctx.socket(:PULL)
+      pull.linger = 0
+      pull.bind("inproc://test.priority.#{name}")
+      poller.register(ZMQ::Pollitem(pull, ZMQ::POLLIN, priority: priority, weight: weight))
+      push = ctx.socket(:PUSH)
+      push.linger = 0
+      push.connect("inproc://test.priority.#{name}")
+      socks[name] = [pull, push]
+    end
+    6.times { |i| socks[:bulk][1].send("b#{i}") }
+    2.times { |i| socks[:control][1].send("c#{i}") }
+    sleep 0.1
+
+    assert_equal 2, poller.poll(1)
+    assert_equal [socks[:control][0], socks[:bulk][0]], poller.readables
+
+    # control first, then bulk up to 2 (max per socket) * 2 (weight) messages
+    received = poller.poll_recv(1, 2).map { |_, msg| msg }
+    assert_equal %w(c0 c1 b0 b1 b2 b3), received
+    assert_equal %w(b4 b5), poller.poll_recv(1, 2).map { |_, msg| msg }
+  ensure
+    ctx.destroy
+  end
+
   def test_poll_ruby_sockets
     poller = ZMQ::Poller.new
     server = TCPServer.new("127.0.0.1", 0)
@@ -147,6 +301,142 @@ class TestZmqPoller < ZmqTestCase
     assert_equal [], poller.readables
   end
 
+  def test_register_remove_churn
+    poller = ZMQ::Poller.new
+    pipes = (1..16).map { IO.pipe }
+    pipes.each { |r, w| poller.register(ZMQ::Pollitem(r, ZMQ::POLLIN)) }
+    pipes.each_with_index { |(r, w), i| assert poller.remove(r) if i.even? }
+    assert_equal false, poller.remove(pipes[0][0])
+    pipes.each { |r, w| w.write("x") }
+    assert_equal 8, poller.poll(1)
+    assert_equal pipes.each_with_index.select { |_, i| i.odd? }.map { |(r, _), _| r }.sort_by(&:fileno), poller.readables.sort_by(&:fileno)
+    pipes.each_with_index { |(r, w), i| assert poller.remove(r) if i.odd? }
+    assert_equal 0, poller.poll_nonblock
+  ensure
+    pipes.flatten.each(&:close) if pipes
+  end
+
+  def test_epoll_backend
+    assert_equal :zmq_poll, ZMQ::Poller.new.backend
+    assert_raises ArgumentError do
+      ZMQ::Poller.new(backend: :kqueue)
+    end
+    return unless RUBY_PLATFORM =~ /linux/
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new(backend: :epoll)
+    assert_equal :epoll, poller.backend
+    rep = ctx.socket(:REP)
+    rep.linger = 0
+    rep.bind("inproc://test.epoll")
+    req = ctx.socket(:REQ)
+    req.linger = 0
+    req.connect("inproc://test.epoll")
+    r, w = IO.pipe
+
+    assert_equal 0, poller.poll_nonblock
+    assert poller.register_readable(rep)
+    assert_raises ZMQ::Error do
+      poller.register_writable(rep)
+    end
+    assert poller.register(ZMQ::Pollitem(r, ZMQ::POLLIN))
+    assert_equal 0, poller.poll_nonblock
+
+    assert req.send("request")
+    w.write("message")
+    sleep 0.1
+
+    assert_equal 2, poller.poll(1)
+    assert_equal [rep, r].sort_by(&:object_id), poller.readables.sort_by(&:object_id)
+    assert_equal [], poller.writables
+
+    # edge triggered ZMQ_FD - still readable until drained
+    assert_equal 2, poller.poll(1)
+    assert_equal "request", rep.recv
+    assert_equal "message", r.read(7)
+    assert_equal 0, poller.poll_nonblock
+
+    assert poller.remove(rep)
+    assert_equal [], poller.readables
+  ensure
+    ctx.destroy if ctx
+  end
+
+  def test_epoll_backend_socket_operations
+    return unless RUBY_PLATFORM =~ /linux/
+    ctx = ZMQ::Context.new
+    poller = ZMQ::Poller.new(backend: :epoll)
+    other = ZMQ::Poller.new(backend: :epoll)
+    rep = ctx.socket(:REP)
+    rep.linger = 0
+    rep.bind("inproc://test.epoll-operations")
+    dealer = ctx.socket(:DEALER)
+    dealer.linger = 0
+    dealer.connect("inproc://test.epoll-operations")
+    item = ZMQ::Pollitem(dealer, ZMQ::POLLIN)
+    assert poller.register(item)
+    assert other.register(item)
+    assert_equal 0, poller.poll_nonblock
+
+    # sending processes the reply's activation command, which the ZMQ_FD then won't signal again
+    assert dealer.sendm("")
+    assert dealer.send("request")
+    assert_equal "request", rep.recv
+    assert rep.send("reply")
+    sleep 0.1
+    dealer.events
+    assert_equal 1, poller.poll(1)
+    assert_equal [dealer], poller.readables
+    assert_equal 1, other.poll(1)
+    assert_equal "", dealer.recv
+    assert_equal "reply", dealer.recv
+    assert_equal 0, poller.poll_nonblock
+    assert_equal 0, other.poll_nonblock
+
+    # a reply left queued by another poller's poll_recv is still reported
+    2.times do |i|
+      assert dealer.sendm("")
+      assert dealer.send("request #{i}")
+      assert_equal "request #{i}", rep.recv
+      assert rep.send("reply #{i}")
+    end
+    sleep 0.1
+    assert_equal [[dealer, ["", "reply 0"]]], poller.poll_recv(1)
+    assert_equal 1, other.poll(1)
+    assert_equal [dealer], other.readables
+    assert_equal [[dealer, ["", "reply 1"]]], other.poll_recv(1)
+    assert_equal 0, poller.poll_nonblock
+
+    dealer.close
+    assert poller.remove(item)
+    assert other.remove(item)
+    assert_equal 0, poller.poll_nonblock
+  ensure
+    ctx.destroy if ctx
+  end
+
+  def test_epoll_backend_recycled_fd
+    return unless RUBY_PLATFORM =~ /linux/
+    poller = ZMQ::Poller.new(backend: :epoll)
+    r, w = IO.pipe
+    assert poller.register_readable(r)
+    r.close
+    w.close
+
+    # likely gets the numbers of the pipe just closed
+    r2, w2 = IO.pipe
+    assert poller.register_readable(r2)
+    assert_raises ZMQ::Error do
+      poller.register(ZMQ::Pollitem(r2, ZMQ::POLLIN))
+    end
+    assert poller.remove(r)
+    w2.write("x")
+    assert_equal 1, poller.poll(1)
+    assert_equal [r2], poller.readables
+  ensure
+    r2.close if r2
+    w2.close if w2
+  end
+
   def test_writables
     poller = ZMQ::Poller.new
     assert_equal [], poller.writables
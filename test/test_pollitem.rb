@@ -34,6 +34,19 @@ class TestZmqPollitem < ZmqTestCase
     srv.close if srv
   end
 
+  def test_priority_and_weight
+    pollitem = ZMQ::Pollitem.new(STDIN, ZMQ::POLLIN)
+    assert_equal 0, pollitem.priority
+    assert_equal 1, pollitem.weight
+    pollitem = ZMQ::Pollitem.new(STDIN, ZMQ::POLLIN, priority: 2, weight: 4)
+    assert_equal 2, pollitem.priority
+    assert_equal 4, pollitem.weight
+    assert_equal 1, ZMQ::Pollitem.new(STDIN, priority: 1).priority
+    assert_raises ArgumentError do
+      ZMQ::Pollitem.new(STDIN, ZMQ::POLLIN, weight: 0)
+    end
+  end
+
   def test_verbose
     ctx = ZMQ::Context.new
     rep = ctx.bind(:REP, 'inproc://test.pollitem-verbose')
@@ -263,6 +263,243 @@ class TestZmqSocket < ZmqTestCase
     ctx.destroy
   end
   
+  def test_send_receive_zero_copy
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-send_receive_zero_copy")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-send_receive_zero_copy")
+    ZMQ.zero_copy_threshold = 65536
+    payload = ("x" * ZMQ.zero_copy_threshold).freeze
+    assert req.sendm(payload)
+    assert req.send(payload)
+    GC.start
+    assert_equal payload, rep.recv
+    assert_equal payload, rep.recv
+    assert req.sendv([payload, "tail"])
+    assert_equal payload, rep.recv
+    assert_equal "tail", rep.recv
+  ensure
+    ZMQ.zero_copy_threshold = nil
+    ctx.destroy
+  end
+
+  def test_receive_zero_copy
+    ctx = ZMQ::Context.new
+    ZMQ.zero_copy_recv_threshold = 1024
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-receive_zero_copy")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-receive_zero_copy")
+    payload = "x" * 4096
+    assert req.send(payload)
+    assert req.send("small")
+    msg = rep.recv
+    assert msg.frozen?
+    assert_equal Encoding::BINARY, msg.encoding
+    small = rep.recv
+    assert !small.frozen?
+    # below the minimum view size, thus copied into a terminated String
+    assert req.send("1" * 2048)
+    assert !rep.recv.frozen?
+    GC.start
+    assert_equal payload, msg
+    assert_equal "small", small
+  ensure
+    ZMQ.zero_copy_recv_threshold = nil
+    ctx.destroy
+  end
+
+  def test_send_nonblock
+    ctx = ZMQ::Context.new
+    push = ctx.socket(:PUSH)
+    push.bind("inproc://test.socket-send_nonblock")
+    frame = ZMQ::Frame("frame")
+    msg = ZMQ::Message.new
+    msg.pushstr "body"
+    msg.pushstr "header"
+    assert_equal false, push.send_nonblock("message")
+    assert_equal false, push.sendm_nonblock("message")
+    assert_equal false, push.send_frame_nonblock(frame)
+    assert_equal false, push.send_message_nonblock(msg)
+    assert_equal 2, msg.size
+    pull = ctx.socket(:PULL)
+    pull.connect("inproc://test.socket-send_nonblock")
+    assert push.sendm_nonblock("mes")
+    assert push.send_nonblock("sage")
+    assert push.send_frame_nonblock(frame)
+    assert push.send_message_nonblock(msg)
+    assert_equal "mes", pull.recv
+    assert_equal "sage", pull.recv
+    assert_equal "frame", pull.recv
+    recvd_msg = pull.recv_message
+    assert_equal "header", recvd_msg.popstr
+    assert_equal "body", recvd_msg.popstr
+  ensure
+    ctx.destroy
+  end
+
+  def test_stats
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-stats")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-stats")
+    stats = rep.stats
+    assert stats.frozen?
+    assert_equal 0, stats[:messages_received]
+    assert_nil rep.recv_nonblock
+    assert_equal 1, rep.stats[:eagain]
+    assert req.send("message")
+    req.send_message(ZMQ::Message("multi", "part"))
+    assert_equal "message", rep.recv
+    assert rep.recv_message
+    assert_equal 3, req.stats[:messages_sent]
+    assert_equal 16, req.stats[:bytes_sent]
+    assert_equal 3, rep.stats[:messages_received]
+    assert_equal 16, rep.stats[:bytes_received]
+    rep.fast_path = false
+    releases = rep.stats[:gvl_releases]
+    assert req.send("message")
+    assert_equal "message", rep.recv
+    assert_equal releases + 1, rep.stats[:gvl_releases]
+    assert rep.stats[:blocked_ns] > 0
+    rep.reset_stats
+    assert rep.stats.values.all?{|v| v == 0 }
+  ensure
+    ctx.destroy
+  end
+
+  def test_latency
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-latency")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-latency")
+    assert_equal 0, rep.recv_latency.count
+    rep.fast_path = false
+    assert req.send("message")
+    assert_equal "message", rep.recv
+    latency = rep.recv_latency
+    assert_instance_of ZMQ::Histogram, latency
+    assert_equal 1, latency.count
+    assert latency.max > 0
+    assert_equal 0, rep.send_latency.count
+    rep.reset_stats
+    assert_equal 0, rep.recv_latency.count
+  ensure
+    ctx.destroy
+  end
+
+  def test_recv_into
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-recv_into")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-recv_into")
+    buf = String.new
+    assert_nil rep.recv_into_nonblock(buf)
+    assert_equal "", buf
+    assert req.send("message")
+    assert_equal 7, rep.recv_into(buf)
+    assert_equal "message", buf
+    assert req.send("x" * 64)
+    sleep 0.1
+    assert_equal 64, rep.recv_into_nonblock(buf)
+    assert_equal "x" * 64, buf
+    assert req.send("hi")
+    assert_equal 2, rep.recv_into(buf)
+    assert_equal "hi", buf
+    assert_raises TypeError do
+      rep.recv_into(nil)
+    end
+    assert_raises RuntimeError do
+      rep.recv_into("".freeze)
+    end
+  ensure
+    ctx.destroy
+  end
+
+  def test_send_packed
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-send_packed")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-send_packed")
+    obj = {"id" => 1, "tags" => ["a", "b"], "nested" => {"ok" => true, "none" => nil},
+           "ints" => [-1, -33, 127, 255, 65536, 2**40, -2**40, 2**64 - 1], "pi" => 3.25, "long" => "x" * 300}
+    assert req.send_packed(obj)
+    assert_equal obj, rep.recv_unpacked
+    assert req.send_packed(:sym => "bin\xFF".force_encoding("BINARY"))
+    frame = rep.recv_frame
+    assert_equal "\x81\xA3sym\xC4\x04bin\xFF".force_encoding("BINARY"), frame.data
+    unpacked = frame.unpack_msgpack
+    assert_equal Encoding::BINARY, unpacked["sym"].encoding
+    assert_equal [1, "a"], ZMQ::Frame("\x92\x01\xA1a").unpack_msgpack
+    assert_raises(TypeError){ req.send_packed(Object.new) }
+    assert_raises(ZMQ::Error){ ZMQ::Frame("\x92\x01").unpack_msgpack }
+    assert_raises(ZMQ::Error){ ZMQ::Frame("\x01\x02").unpack_msgpack }
+  ensure
+    ctx.destroy
+  end
+
+  def test_compression
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-compression")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-compression")
+    assert_nil req.compression
+    req.compression = {codec: :zlib, level: 1, min_size: 64}
+    assert_equal({codec: :zlib, level: 1, min_size: 64}, req.compression)
+    rep.compression = true
+    assert_equal 1024, rep.compression[:min_size]
+    payload = "compressible " * 100
+    assert req.send(payload)
+    assert_equal payload, rep.recv
+    assert req.send("tiny")
+    assert_equal "tiny", rep.recv
+    assert req.sendv(["part", payload])
+    assert_equal ["part", payload], rep.recv_batch(1)[0]
+    req.send_frame ZMQ::Frame(payload)
+    assert_equal payload, rep.recv_frame.data
+    msg = ZMQ::Message.new
+    msg.addstr "header"
+    msg.addstr payload
+    req.send_message msg
+    assert_equal ["header", payload], rep.recv_message.to_a.map(&:data)
+    rep.compression = nil
+    assert req.send(payload)
+    frame = rep.recv_frame
+    assert_equal "\xC1ZC\x01".b, frame.data[0, 4].b
+    assert frame.size < payload.size
+    req.send("raw")
+    assert_equal "\xC1ZC\x00raw".b, rep.recv.b
+    rep.compression = {codec: :zlib}
+    req.compression = false
+    req.send("unframed")
+    assert_raises(ZMQ::Error){ rep.recv }
+    # plain payloads that happen to start with a flag byte aren't mistaken for framed ones
+    req.send("\x00raw")
+    assert_raises(ZMQ::Error){ rep.recv }
+    assert_raises(ArgumentError){ req.compression = {codec: :lz4} }
+    assert_raises(ArgumentError){ req.compression = {level: 10} }
+  ensure
+    ctx.destroy
+  end
+
+  def test_compression_unsupported_socket_types
+    ctx = ZMQ::Context.new
+    [:PUB, :XPUB, :SUB, :XSUB, :ROUTER].each do |type|
+      sock = ctx.socket(type)
+      assert_raises(ArgumentError){ sock.compression = true }
+      assert_nil sock.compression
+      sock.compression = nil
+    end
+  ensure
+    ctx.destroy
+  end
+
   def test_send_receive_with_percent_in_string
     ctx = ZMQ::Context.new
     rep = ctx.socket(:PAIR)
@@ -304,6 +541,31 @@ class TestZmqSocket < ZmqTestCase
     ctx.destroy
   end
 
+  def test_fast_path
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-fast_path")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-fast_path")
+    assert rep.fast_path?
+    [true, false].each do |enabled|
+      rep.fast_path = enabled
+      req.fast_path = enabled
+      assert_equal enabled, req.fast_path?
+      assert req.sendm("fast")
+      assert req.send("path")
+      assert_equal "fast", rep.recv
+      assert_equal ZMQ::Frame("path"), rep.recv_frame
+      req.send_message(ZMQ::Message("a", "b"))
+      assert_equal ZMQ::Message("a", "b"), rep.recv_message
+    end
+    assert_raises TypeError do
+      rep.fast_path = :yes
+    end
+  ensure
+    ctx.destroy
+  end
+
   def test_receive_nonblock
     ctx = ZMQ::Context.new
     rep = ctx.socket(:REP)
@@ -334,6 +596,60 @@ class TestZmqSocket < ZmqTestCase
     ctx.destroy
   end
 
+  def test_sendv
+    ctx = ZMQ::Context.new
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.socket-sendv")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.socket-sendv")
+    frame = ZMQ::Frame("frame")
+    assert req.sendv(["topic", frame, [1,0,1].pack('c*')])
+    assert_equal "topic", rep.recv
+    assert rep.rcvmore?
+    assert_equal "frame", rep.recv
+    assert_equal [1,0,1].pack('c*'), rep.recv
+    assert !rep.rcvmore?
+    assert !frame.gone?
+    assert_raises ArgumentError do
+      req.sendv([])
+    end
+    assert_raises TypeError do
+      req.sendv(["topic", :payload])
+    end
+  ensure
+    ctx.destroy
+  end
+
+  def test_recv_batch
+    ctx = ZMQ::Context.new
+    pull = ctx.socket(:PULL)
+    pull.bind("inproc://test.socket-recv_batch")
+    push = ctx.socket(:PUSH)
+    push.connect("inproc://test.socket-recv_batch")
+    assert_equal [], pull.recv_batch(10, 10)
+    push.send("a")
+    push.sendv(["b", "c"])
+    push.send("d")
+    push.send("e")
+    sleep 0.1
+    assert_equal ["a", ["b", "c"], "d"], pull.recv_batch(3)
+    assert_equal ["e"], pull.recv_batch(10, 100)
+    assert_raises ArgumentError do
+      pull.recv_batch(0)
+    end
+    pull.compression = push.compression = true
+    push.send("framed")
+    push.compression = nil
+    push.send("unframed")
+    sleep 0.1
+    # messages received before a malformed one are returned, and the error raised by the next receive
+    assert_equal ["framed"], pull.recv_batch(10)
+    assert_raises(ZMQ::Error){ pull.recv_batch(10, 10) }
+    assert_equal [], pull.recv_batch(10, 10)
+  ensure
+    ctx.destroy
+  end
+
   def test_send_receive_frame
     ctx = ZMQ::Context.new
     rep = ctx.socket(:REP)
@@ -0,0 +1,61 @@
+# encoding: utf-8
+
+require File.expand_path("../helper.rb", __FILE__)
+
+class TestZmqTrace < ZmqTestCase
+  def teardown
+    ZMQ::Trace.disable
+  end
+
+  def test_enable
+    assert !ZMQ::Trace.enabled?
+    assert_nil ZMQ::Trace.capacity
+    assert_equal "", ZMQ::Trace.dump
+    ZMQ::Trace.enable(1000)
+    assert ZMQ::Trace.enabled?
+    assert_equal 1024, ZMQ::Trace.capacity
+    assert_raises ArgumentError do
+      ZMQ::Trace.enable(0)
+    end
+    ZMQ::Trace.disable
+    assert !ZMQ::Trace.enabled?
+  end
+
+  def test_records
+    ctx = ZMQ::Context.new
+    ZMQ::Trace.enable
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.trace-records")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.trace-records")
+    payload = "x" * 100
+    assert req.send(payload)
+    assert_equal payload, rep.recv
+    assert req.send_frame(ZMQ::Frame("frame"))
+    assert rep.recv_frame
+    records = ZMQ::Trace.records
+    assert_equal [:send, :recv, :send_frame, :recv_frame], records.map(&:op)
+    assert_equal 100, records[0].size
+    assert_equal "x" * ZMQ::Trace::CAPTURE, records[0].payload
+    assert_equal "frame", records[3].payload
+    assert records.all?{|r| r.timestamp > 0 }
+    assert_equal 4 * ZMQ::Trace::RECORD_SIZE, ZMQ::Trace.dump.bytesize
+    ZMQ::Trace.clear
+    assert_equal [], ZMQ::Trace.records
+  ensure
+    ctx.destroy
+  end
+
+  def test_overwrite_oldest
+    ctx = ZMQ::Context.new
+    ZMQ::Trace.enable(4)
+    rep = ctx.socket(:PAIR)
+    rep.bind("inproc://test.trace-overwrite_oldest")
+    req = ctx.socket(:PAIR)
+    req.connect("inproc://test.trace-overwrite_oldest")
+    6.times{|i| req.send(i.to_s) }
+    assert_equal %w(2 3 4 5), ZMQ::Trace.records.map(&:payload)
+  ensure
+    ctx.destroy
+  end
+end
@@ -36,6 +36,32 @@ class TestZmq < ZmqTestCase
     assert_instance_of Fixnum, ZMQ.errno
   end
 
+  def test_zero_copy_threshold
+    assert_nil ZMQ.zero_copy_threshold
+    ZMQ.zero_copy_threshold = 0
+    assert_equal 0, ZMQ.zero_copy_threshold
+    ZMQ.zero_copy_threshold = nil
+    assert_nil ZMQ.zero_copy_threshold
+    ZMQ.zero_copy_threshold = 1024
+    assert_equal 1024, ZMQ.zero_copy_threshold
+    assert_raises ArgumentError do
+      ZMQ.zero_copy_threshold = -1
+    end
+  ensure
+    ZMQ.zero_copy_threshold = nil
+  end
+
+  def test_zero_copy_recv_threshold
+    assert_nil ZMQ.zero_copy_recv_threshold
+    ZMQ.zero_copy_recv_threshold = 1024
+    assert_equal 1024, ZMQ.zero_copy_recv_threshold
+    assert_raises ArgumentError do
+      ZMQ.zero_copy_recv_threshold = -1
+    end
+  ensure
+    ZMQ.zero_copy_recv_threshold = nil
+  end
+
   def test_select
     ctx = ZMQ::Context.new
     poller = ZMQ::Poller.new